@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <string>
 #include <cassert>
 
@@ -54,7 +55,7 @@ private:
 
     friend constexpr Accumulator& operator<<(Accumulator& helper, char c)
     {
-        helper.indices[c] = helper.size++;
+        helper.indices[static_cast<unsigned char>(c)] = helper.size++;
         return helper;
     }
 
@@ -64,7 +65,7 @@ public:
     // Returns '-1' if c is not in alphabet, otherwise value which '>= 0'.
     int32_t index_of(char c) const
     {
-        return char_to_index[c];
+        return char_to_index[static_cast<unsigned char>(c)];
     }
 
     // Checks does provided string produced of this alphabet or not.
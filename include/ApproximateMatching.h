@@ -0,0 +1,398 @@
+#pragma once
+
+#include "SuffixTree.h"
+
+#include <cstring>
+
+namespace custom
+{
+
+/**
+ * @brief Approximate occurrence of pattern
+ *
+ * Substring `text.substr(position, length)` differs from pattern by `errors` edit operations.
+ */
+struct ApproximateMatch
+{
+    int32_t position;
+    int32_t length;
+    int32_t errors;
+};
+
+// Which approximate occurrences are reported.
+enum class ApproximateMode
+{
+    // the best occurrence of each start position with at most k errors
+    all,
+
+    // occurrences with the least count of errors among all positions
+    best
+};
+
+
+/**
+ * @brief Occurrences of pattern with at most k mismatches
+ *
+ * Tree is walked depth-first with budget of mismatches, so common prefixes of suffixes are compared
+ * once. Labels of edges are compared with pattern by 8 letters at a time. Before search lower bound
+ * of mismatches is computed for each suffix of pattern: it is split greedily to pieces which don't
+ * occur in source (by matching statistics), each piece costs at least one mismatch. Branch is cut
+ * as soon as its mismatches and lower bound of the rest of pattern exceed k.
+ *
+ * @param tree suffix tree
+ * @param pattern string to match
+ * @param k max count of mismatches
+ * @param sink called as `sink(const ApproximateMatch&)` for each occurrence, length of occurrence is
+ *  length of pattern; returns false to stop query
+ * @returns false if query was stopped by sink
+ */
+template <typename Alphabet, typename Sink>
+bool find_approx_hamming(const SuffixTree<Alphabet>& tree, std::string_view pattern, int32_t k, Sink&& sink);
+
+// Same as above, but occurrences are returned in vector.
+template <typename Alphabet>
+std::vector<ApproximateMatch> find_approx_hamming(const SuffixTree<Alphabet>& tree, std::string_view pattern, int32_t k);
+
+/**
+ * @brief Occurrences of pattern with at most k edit operations (insertions, deletions, substitutions)
+ *
+ * Tree is walked depth-first and each path carries column of edit distances between path and prefixes
+ * of pattern in Myers' bit-parallel form, so each letter of path costs O(1) and shared prefixes of
+ * suffixes are computed once. Path is cut when minimum of column exceeds k (or can't improve the best
+ * occurrence of path), then all leafs below are reported with the best occurrence found on path.
+ *
+ * @param tree suffix tree
+ * @param pattern non-empty string to match, not longer than 64 letters (otherwise nothing is reported)
+ * @param k max count of errors
+ * @param mode the best occurrence for each start position or only occurrences with the least errors
+ * @param sink called as `sink(const ApproximateMatch&)`, the shortest of the best occurrences is taken
+ *  for each position; returns false to stop query
+ * @returns false if query was stopped by sink
+ */
+template <typename Alphabet, typename Sink>
+bool find_approx_edit(const SuffixTree<Alphabet>& tree, std::string_view pattern, int32_t k, ApproximateMode mode, Sink&& sink);
+
+// Same as above, but occurrences are returned in vector.
+template <typename Alphabet>
+std::vector<ApproximateMatch> find_approx_edit(const SuffixTree<Alphabet>& tree, std::string_view pattern, int32_t k, 
+                                               ApproximateMode mode = ApproximateMode::all);
+
+
+namespace details
+{
+
+// count of different letters of two strings, counting stops as soon as it exceeds limit
+inline int32_t count_mismatches(const char* lhs, const char* rhs, int32_t length, int32_t limit)
+{
+    constexpr uint64_t low_bits = 0x7f7f7f7f7f7f7f7full;
+    constexpr uint64_t high_bits = ~low_bits;
+
+    int32_t mismatches = 0, idx = 0;
+    for(; idx + 8 <= length && mismatches <= limit; idx += 8)
+    {
+        uint64_t lhs_word, rhs_word;
+        std::memcpy(&lhs_word, lhs + idx, 8);
+        std::memcpy(&rhs_word, rhs + idx, 8);
+
+        // high bit of each byte is set if bytes differ
+        uint64_t difference = lhs_word ^ rhs_word;
+        uint64_t nonzero = (((difference & low_bits) + low_bits) | difference) & high_bits;
+        mismatches += __builtin_popcountll(nonzero);
+    }
+
+    for(; idx < length && mismatches <= limit; ++idx)
+        mismatches += lhs[idx] != rhs[idx];
+
+    return mismatches;
+}
+
+
+// lower bounds of mismatches for each suffix of pattern, bounds[m] is 0
+template <typename Alphabet>
+void mismatches_lower_bounds(const SuffixTree<Alphabet>& tree, std::string_view pattern, std::vector<int32_t>& bounds)
+{
+    bounds.assign(pattern.size() + 1, 0);
+    tree.matching_statistics(pattern, [&](size_t first, const typename SuffixTree<Alphabet>::Match* matches, size_t count)
+    {
+        for(size_t idx = 0; idx < count; ++idx)
+            bounds[first + idx] = matches[idx].length;
+
+        return true;
+    });
+
+    // piece which is longer than the longest match by one letter doesn't occur in source
+    for(size_t position = pattern.size(); position-- > 0;)
+    {
+        size_t piece_end = position + bounds[position] + 1;
+        bounds[position] = piece_end <= pattern.size() ? bounds[piece_end] + 1 : 0;
+    }
+}
+
+
+// minimum of column of edit distances given by its top value and vertical deltas
+inline int32_t column_minimum(int32_t top, uint64_t positive, uint64_t negative)
+{
+    int32_t value = top, minimum = top;
+    for(uint64_t changes = positive | negative; changes != 0; changes &= changes - 1)
+    {
+        uint64_t bit = changes & -changes;
+        value += (positive & bit) ? 1 : -1;
+        minimum = std::min(minimum, value);
+    }
+
+    return minimum;
+}
+
+} // namespace details
+
+
+template <typename Alphabet, typename Sink>
+bool find_approx_hamming(const SuffixTree<Alphabet>& tree, std::string_view pattern, int32_t k, Sink&& sink)
+{
+    using node_reference = typename SuffixTree<Alphabet>::node_reference;
+
+    ScratchVector<int32_t> bounds_scratch;
+    std::vector<int32_t>& bounds = bounds_scratch.get();
+    details::mismatches_lower_bounds(tree, pattern, bounds);
+    if(k < 0 || bounds[0] > k)
+    {
+        return true;
+    }
+
+    struct State
+    {
+        node_reference node;
+        int32_t depth;
+        int32_t mismatches;
+    };
+
+    ScratchVector<State> stack_scratch;
+    std::vector<State>& stack = stack_scratch.get();
+    stack.assign(1, {tree.root(), 0, 0});
+
+    int32_t length = pattern.size();
+    bool stopped = false;
+
+    auto report = [&](node_reference node, int32_t mismatches)
+    {
+        if(tree.is_leaf(node))
+        {
+            return sink(ApproximateMatch{tree.suffix_of(node), length, mismatches});
+        }
+
+        auto [leaf_begin, leaf_end] = tree.leaf_range(node);
+        for(int32_t leaf_number = leaf_begin; leaf_number < leaf_end; ++leaf_number)
+            if(!sink(ApproximateMatch{tree.suffix_at(leaf_number), length, mismatches}))
+                return false;
+
+        return true;
+    };
+
+    while(!stack.empty() && !stopped)
+    {
+        State state = stack.back();
+        stack.pop_back();
+
+        tree.for_each_child(state.node, [&](node_reference child, std::string_view label)
+        {
+            // suffix of terminal doesn't start at position of source
+            if(stopped || (tree.is_leaf(child) && tree.suffix_of(child) == tree.suffixes_count() - 1))
+                return;
+
+            // terminal is not a part of source, it ends each edge to leaf
+            int32_t usable = tree.is_leaf(child) ? label.size() - 1 : label.size();
+            if(tree.is_leaf(child) && state.depth + usable < length)
+                return;
+
+            int32_t compared = std::min(usable, length - state.depth);
+
+            int32_t limit = k - state.mismatches;
+            int32_t mismatches = state.mismatches + details::count_mismatches(label.data(), pattern.data() + state.depth, compared, limit);
+
+            int32_t depth = state.depth + compared;
+            if(mismatches + bounds[depth] > k)
+                return;
+
+            if(depth == length)
+                stopped = !report(child, mismatches);
+            else
+                stack.push_back({child, depth, mismatches});
+        });
+    }
+
+    return !stopped;
+}
+
+
+template <typename Alphabet>
+std::vector<ApproximateMatch> find_approx_hamming(const SuffixTree<Alphabet>& tree, std::string_view pattern, int32_t k)
+{
+    std::vector<ApproximateMatch> matches;
+    find_approx_hamming(tree, pattern, k, [&](const ApproximateMatch& match)
+    {
+        matches.push_back(match);
+        return true;
+    });
+
+    return matches;
+}
+
+template <typename Alphabet, typename Sink>
+bool find_approx_edit(const SuffixTree<Alphabet>& tree, std::string_view pattern, int32_t k, ApproximateMode mode, Sink&& sink)
+{
+    using node_reference = typename SuffixTree<Alphabet>::node_reference;
+
+    // column must fit into one machine word
+    int32_t length = pattern.size();
+    if(length == 0 || length > 64 || k < 0)
+    {
+        return true;
+    }
+
+    // bit masks of pattern positions for each letter
+    ScratchVector<uint64_t> letter_masks_scratch;
+    std::vector<uint64_t>& letter_masks = letter_masks_scratch.get();
+    letter_masks.assign(256, 0);
+    for(int32_t idx = 0; idx < length; ++idx)
+        letter_masks[static_cast<unsigned char>(pattern[idx])] |= uint64_t(1) << idx;
+
+    uint64_t last_bit = uint64_t(1) << (length - 1);
+    uint64_t all_bits = last_bit | (last_bit - 1);
+
+    // column is kept as vertical deltas: row 'j' is edit distance between path and pattern[0, j)
+    struct State
+    {
+        node_reference node;
+        int32_t depth;
+        uint64_t positive;
+        uint64_t negative;
+        int32_t score;
+
+        // the best occurrence on path
+        int32_t best_errors;
+        int32_t best_length;
+    };
+
+    constexpr int32_t no_errors = std::numeric_limits<int32_t>::max();
+    ScratchVector<State> stack_scratch;
+    ScratchVector<ApproximateMatch> found_scratch;
+    std::vector<State>& stack = stack_scratch.get();
+    std::vector<ApproximateMatch>& found = found_scratch.get();
+    stack.assign(1, {tree.root(), 0, all_bits, 0, length, length <= k ? length : no_errors, 0});
+
+    bool stopped = false;
+    auto report = [&](node_reference node, int32_t errors, int32_t match_length)
+    {
+        if(errors > k)
+        {
+            return true;
+        }
+
+        // in best mode occurrences are reported after search, when the least count of errors is known
+        auto emit = [&](int32_t position)
+        {
+            if(mode == ApproximateMode::best)
+            {
+                k = errors;
+                found.push_back({position, match_length, errors});
+                return true;
+            }
+
+            return static_cast<bool>(sink(ApproximateMatch{position, match_length, errors}));
+        };
+
+        if(tree.is_leaf(node))
+        {
+            return emit(tree.suffix_of(node));
+        }
+
+        auto [leaf_begin, leaf_end] = tree.leaf_range(node);
+        for(int32_t leaf_number = leaf_begin; leaf_number < leaf_end; ++leaf_number)
+            if(!emit(tree.suffix_at(leaf_number)))
+                return false;
+
+        return true;
+    };
+
+    while(!stack.empty() && !stopped)
+    {
+        State state = stack.back();
+        stack.pop_back();
+
+        tree.for_each_child(state.node, [&](node_reference child, std::string_view label)
+        {
+            if(stopped)
+                return;
+
+            // suffix which consists of terminal only doesn't start at position of source
+            if(tree.is_leaf(child) && tree.suffix_of(child) == tree.suffixes_count() - 1)
+                return;
+
+            // terminal is not a part of source, it ends each edge to leaf
+            int32_t usable = tree.is_leaf(child) ? label.size() - 1 : label.size();
+
+            State next = state;
+            next.node = child;
+
+            bool cut = false;
+            for(int32_t idx = 0; idx < usable && !cut; ++idx)
+            {
+                // Myers' step, distance between path and empty prefix grows by one
+                uint64_t equal = letter_masks[static_cast<unsigned char>(label[idx])];
+                uint64_t vertical = equal | next.negative;
+                uint64_t horizontal = (((equal & next.positive) + next.positive) ^ next.positive) | equal;
+                uint64_t horizontal_positive = next.negative | ~(horizontal | next.positive);
+                uint64_t horizontal_negative = next.positive & horizontal;
+
+                next.score += (horizontal_positive & last_bit) ? 1 : 0;
+                next.score -= (horizontal_negative & last_bit) ? 1 : 0;
+
+                horizontal_positive = (horizontal_positive << 1) | 1;
+                horizontal_negative <<= 1;
+                next.positive = (horizontal_negative | ~(vertical | horizontal_positive)) & all_bits;
+                next.negative = horizontal_positive & vertical & all_bits;
+                ++next.depth;
+
+                if(next.score < next.best_errors && next.score <= k)
+                {
+                    next.best_errors = next.score;
+                    next.best_length = next.depth;
+                }
+
+                // distances of longer paths are not less than minimum of column
+                int32_t bound = std::min(k + 1, next.best_errors);
+                cut = details::column_minimum(next.depth, next.positive, next.negative) >= bound;
+            }
+
+            if(cut || tree.is_leaf(child))
+                stopped = !report(child, next.best_errors, next.best_length);
+            else
+                stack.push_back(next);
+        });
+    }
+
+    if(mode == ApproximateMode::best)
+    {
+        for(const ApproximateMatch& match : found)
+            if(match.errors == k && !sink(match))
+                return false;
+    }
+
+    return !stopped;
+}
+
+
+template <typename Alphabet>
+std::vector<ApproximateMatch> find_approx_edit(const SuffixTree<Alphabet>& tree, std::string_view pattern, int32_t k, ApproximateMode mode)
+{
+    std::vector<ApproximateMatch> matches;
+    find_approx_edit(tree, pattern, k, mode, [&](const ApproximateMatch& match)
+    {
+        matches.push_back(match);
+        return true;
+    });
+
+    return matches;
+}
+
+} // custom
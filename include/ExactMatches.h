@@ -0,0 +1,218 @@
+#pragma once
+
+#include "SuffixTree.h"
+
+namespace custom
+{
+
+/**
+ * @brief Exact match of read and reference (source of tree)
+ *
+ * `read.substr(read_position, length) == text.substr(reference_position, length)`. For reverse
+ * seeds read position is counted in reverse complement of read.
+ */
+struct Seed
+{
+    int32_t read_position;
+    int32_t reference_position;
+    int32_t length;
+    bool reverse;
+};
+
+// Kind of reported matches.
+enum class SeedMode
+{
+    // maximal exact matches: can't be extended to the left or to the right
+    mem,
+
+    // super-maximal exact matches: MEMs which aren't contained in other MEM of read
+    smem
+};
+
+/**
+ * @brief Seeds of several reads in one buffer
+ *
+ * Seeds of read `r` are in range `[offsets[r], offsets[r + 1])` of `seeds`.
+ */
+struct SeedBatch
+{
+    std::vector<Seed> seeds;
+    std::vector<size_t> offsets;
+};
+
+
+/**
+ * @brief Maximal exact matches of read against reference
+ *
+ * Read is streamed through tree as for matching statistics, so the longest match of each read
+ * position is found in O(1) amortized time. SMEM starts where the longest match is not contained
+ * in match of previous position. For MEMs shorter matches are taken from ancestors of the longest
+ * match's locus down to `min_length`: leafs of ancestor outside of child on path branch off from
+ * read, so they are right-maximal, left-maximality is checked by letter before occurrence.
+ *
+ * @param tree suffix tree of reference
+ * @param read read to seed
+ * @param min_length shorter matches are not reported
+ * @param mode MEMs or SMEMs
+ * @param sink called as `sink(const Seed&)` for each occurrence in reference in order of read positions,
+ *  returns false to stop query
+ * @returns false if query was stopped by sink
+ */
+template <typename Alphabet, typename Sink>
+bool find_exact_matches(const SuffixTree<Alphabet>& tree, std::string_view read, int32_t min_length, SeedMode mode, Sink&& sink);
+
+/**
+ * @brief Seeds of batch of reads found by several threads
+ *
+ * @param tree suffix tree of reference
+ * @param reads reads to seed
+ * @param min_length shorter matches are not reported
+ * @param mode MEMs or SMEMs
+ * @param reverse_complement if true reverse complement of each read is seeded too (DNA letters 'ACGT')
+ * @param threads_count max count of threads
+ * @returns forward seeds followed by reverse seeds for each read
+ */
+template <typename Alphabet>
+SeedBatch find_seeds(const SuffixTree<Alphabet>& tree, const std::vector<std::string_view>& reads, int32_t min_length,
+                     SeedMode mode = SeedMode::smem, bool reverse_complement = true, size_t threads_count = default_threads_count());
+
+// Complement of DNA letter, other letters are kept as is.
+inline char complement_of(char ch)
+{
+    switch(ch)
+    {
+        case 'A': return 'T';
+        case 'C': return 'G';
+        case 'G': return 'C';
+        case 'T': return 'A';
+        case 'a': return 't';
+        case 'c': return 'g';
+        case 'g': return 'c';
+        case 't': return 'a';
+        default: return ch;
+    }
+}
+
+
+template <typename Alphabet, typename Sink>
+bool find_exact_matches(const SuffixTree<Alphabet>& tree, std::string_view read, int32_t min_length, SeedMode mode, Sink&& sink)
+{
+    using node_reference = typename SuffixTree<Alphabet>::node_reference;
+
+    min_length = std::max(min_length, 1);
+    std::string_view text = tree.text();
+
+    // reports occurrences of leaf range which can't be extended to the left
+    auto report = [&](int32_t read_position, int32_t length, int32_t leaf_begin, int32_t leaf_end)
+    {
+        for(int32_t leaf_number = leaf_begin; leaf_number < leaf_end; ++leaf_number)
+        {
+            int32_t position = tree.suffix_at(leaf_number);
+            if(read_position > 0 && position > 0 && text[position - 1] == read[read_position - 1])
+                continue;
+
+            if(!sink(Seed{read_position, position, length, false}))
+                return false;
+        }
+
+        return true;
+    };
+
+    typename SuffixTree<Alphabet>::Cursor cursor(tree);
+    size_t end = 0;
+    int32_t previous_length = 0;
+
+    for(size_t position = 0; position < read.size(); ++position)
+    {
+        end += cursor.extend(read.substr(end));
+
+        int32_t length = cursor.length();
+        auto [leaf_begin, leaf_end] = cursor.leaf_range();
+
+        // the longest match is contained in previous one if it is shorter only by the first letter
+        bool contained = previous_length > length;
+        previous_length = length;
+
+        if(length >= min_length && (mode == SeedMode::mem || !contained))
+        {
+            if(!report(position, length, leaf_begin, leaf_end))
+                return false;
+
+            // ancestors of locus: node where locus is placed is skipped
+            node_reference node = cursor.upper_node();
+            if(tree.string_depth(node) == length)
+                node = tree.parent(node);
+
+            while(mode == SeedMode::mem && node != tree.root() && tree.string_depth(node) >= min_length)
+            {
+                auto [node_begin, node_end] = tree.leaf_range(node);
+                int32_t depth = tree.string_depth(node);
+
+                if(!report(position, depth, node_begin, leaf_begin) || !report(position, depth, leaf_end, node_end))
+                    return false;
+
+                leaf_begin = node_begin;
+                leaf_end = node_end;
+                node = tree.parent(node);
+            }
+        }
+
+        // empty match is kept by skipping of letter which doesn't occur in reference
+        if(!cursor.drop_first())
+            ++end;
+    }
+
+    return true;
+}
+
+
+template <typename Alphabet>
+SeedBatch find_seeds(const SuffixTree<Alphabet>& tree, const std::vector<std::string_view>& reads, int32_t min_length,
+                     SeedMode mode, bool reverse_complement, size_t threads_count)
+{
+    threads_count = std::max<size_t>(1, threads_count);
+
+    // seeds of each read are collected separately and then joined to one buffer
+    std::vector<std::vector<Seed>> read_seeds(reads.size());
+    std::vector<std::string> complements(threads_count);
+
+    parallel_for(reads.size(), threads_count, [&](size_t read_idx, size_t thread_idx)
+    {
+        std::vector<Seed>& seeds = read_seeds[read_idx];
+        find_exact_matches(tree, reads[read_idx], min_length, mode, [&](const Seed& seed)
+        {
+            seeds.push_back(seed);
+            return true;
+        });
+
+        if(!reverse_complement)
+            return;
+
+        std::string& complement = complements[thread_idx];
+        complement.assign(reads[read_idx].rbegin(), reads[read_idx].rend());
+        std::transform(complement.begin(), complement.end(), complement.begin(), complement_of);
+
+        find_exact_matches(tree, complement, min_length, mode, [&](Seed seed)
+        {
+            seed.reverse = true;
+            seeds.push_back(seed);
+            return true;
+        });
+    });
+
+    SeedBatch batch;
+    batch.offsets.assign(reads.size() + 1, 0);
+    for(size_t read_idx = 0; read_idx < reads.size(); ++read_idx)
+        batch.offsets[read_idx + 1] = batch.offsets[read_idx] + read_seeds[read_idx].size();
+
+    batch.seeds.resize(batch.offsets.back());
+    parallel_for(reads.size(), threads_count, [&](size_t read_idx, size_t)
+    {
+        std::copy(read_seeds[read_idx].begin(), read_seeds[read_idx].end(), batch.seeds.begin() + batch.offsets[read_idx]);
+        std::vector<Seed>().swap(read_seeds[read_idx]);
+    });
+
+    return batch;
+}
+
+} // custom
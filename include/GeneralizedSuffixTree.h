@@ -0,0 +1,693 @@
+#pragma once
+
+#include "SuffixTree.h"
+#include "RangeMinimum.h"
+
+#include <iterator>
+
+namespace custom
+{
+
+// Separator of documents in generalized suffix tree.
+constexpr const char document_separator = '\1';
+
+/**
+ * @brief Alphabet for generalized sufix tree must exist terminal element and separator of documents.
+ */
+template<char... letters>
+using GeneralizedSuffixTreeAlphabet = Alphabet<terminal_symbol, document_separator, letters...>;
+
+/**
+ * @brief Some common alphabet.
+ */
+using StandartGeneralizedSuffixTreeAlphabet = GeneralizedSuffixTreeAlphabet<
+    ' ', '!', '"', '#', '$', '%', '&', '\'', '(', ')', '*', '+', ',', '-',
+    '.', '/', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', ':', ';', '<',
+    '=', '>', '?', '@', 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K',
+    'L', 'M', 'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z',
+    '[', '\\', ']', '^', '_', '`', 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i',
+    'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x',
+    'y', 'z', '{', '|', '}', '~'
+>;
+
+
+/**
+ * @brief Suffix tree of several documents
+ *
+ * Tree is built over concatenation of documents where each document is followed by separator, so
+ * substrings without separator belong to exactly one document. For each lexicographic leaf number
+ * document of suffix is stored, it allows to answer document queries by leaf range of pattern.
+ *
+ * Distinct documents of leaf range are listed with Muthukrishnan's algorithm: for each leaf number
+ * the previous leaf number of same document is kept with range minimum support. Leaf with minimal
+ * previous link in range is the first one of its document if link points outside of range, so
+ * listing costs O(1) per reported document and doesn't depend on count of occurrences.
+ */
+template <typename Alphabet=StandartGeneralizedSuffixTreeAlphabet>
+class GeneralizedSuffixTree
+{
+    static_assert(Alphabet::is_exist(document_separator), "alphabet must contain separator of documents");
+
+public:
+    /**
+     * @brief Boolean query over documents
+     *
+     * Document matches query if it contains all patterns from `all_of`, at least one pattern from
+     * `any_of` (if it isn't empty) and none of patterns from `none_of`.
+     */
+    struct DocumentQuery
+    {
+        std::vector<std::string_view> all_of;
+        std::vector<std::string_view> any_of;
+        std::vector<std::string_view> none_of;
+    };
+
+    // Maximal unique match of two documents, positions are counted from the beginning of each document.
+    struct UniqueMatch
+    {
+        int32_t first_position;
+        int32_t second_position;
+        int32_t length;
+    };
+
+public:
+    GeneralizedSuffixTree(const std::vector<std::string_view>& documents);
+
+    // Suffix tree over concatenation of documents.
+    const SuffixTree<Alphabet>& tree() const { return suffix_tree; }
+
+    int32_t documents_count() const { return document_begins.size(); }
+
+    // Position of first letter of document in source of tree.
+    int32_t document_begin(int32_t document) const { return document_begins[document]; }
+
+    // Document which contains position of tree's source, separator belongs to previous document.
+    int32_t document_of(int32_t position) const;
+
+    // Document of suffix by its lexicographic leaf number.
+    int32_t document_at(int32_t leaf_number) const { return document_array[leaf_number]; }
+
+    /**
+     * @brief Document listing
+     *
+     * @param pattern string to match as substring
+     * @returns documents which contain pattern in ascending order
+     */
+    std::vector<int32_t> find_documents(std::string_view pattern) const;
+
+    /**
+     * @brief Document listing with O(m + ndoc) time complexity
+     * 
+     * Documents which contain pattern are passed to `sink(int32_t)` in arbitrary order, sink returns 
+     * false to stop query. Doesn't allocate memory in steady state.
+     * 
+     * @returns false if query was stopped by sink
+     */
+    template <typename Sink>
+    bool find_documents(std::string_view pattern, Sink&& sink) const;
+
+    /**
+     * @brief Boolean document query
+     *
+     * Each pattern is resolved to its locus once. Required patterns are processed from the rarest
+     * one and their document lists are intersected with galloping search, so query stops as soon
+     * as no candidates are left.
+     *
+     * @returns documents which match query in ascending order
+     */
+    std::vector<int32_t> find_documents(const DocumentQuery& query) const;
+
+    /**
+     * @brief Longest common substring of two documents
+     * 
+     * One post-order pass marks nodes which have leafs of both documents, deepest of them is answer.
+     * 
+     * @returns substring of tree's text, empty if documents have no common letters
+     */
+    std::string_view longest_common_substring(int32_t first, int32_t second) const;
+
+    /**
+     * @brief Longest substrings common for at least k documents for all k at once
+     * 
+     * Count of distinct documents of each node is count of its leafs minus count of pairs of 
+     * neighbour leafs of same document which have lowest common ancestor inside its subtree. Pairs 
+     * are resolved with Tarjan's offline LCA in the same post-order pass, so pass is linear up to 
+     * inverse Ackermann function. Subtrees of root are processed in parallel.
+     * 
+     * @param threads_count max count of threads
+     * @returns substrings of tree's text, element 'k - 1' is the longest substring of at least 'k' documents
+     */
+    std::vector<std::string_view> longest_common_substrings(size_t threads_count = default_threads_count()) const;
+
+    /**
+     * @brief Maximal unique matches (MUMs) of two documents
+     * 
+     * MUM occurs exactly once in each document and can't be extended in any direction. One post-order 
+     * pass counts leafs of both documents for each node: MUM is string of the deepest node which has 
+     * one leaf of each document and letters before both leafs differ. String cut by end of documents 
+     * is passed up to node where it ends and must be unique there. Other documents don't affect result. 
+     * Time complexity is linear up to sorting of matches.
+     * 
+     * @param first, second documents to compare
+     * @param min_length shorter matches are not reported
+     * @returns matches in ascending order of position in first document
+     */
+    std::vector<UniqueMatch> maximal_unique_matches(int32_t first, int32_t second, int32_t min_length = 1) const;
+
+private:
+    using node_reference = typename SuffixTree<Alphabet>::node_reference;
+
+    // length of common prefix of node's string and its document, string of node could cross separator
+    int32_t length_inside_document(node_reference node) const;
+
+    // leaf range of pattern, empty if pattern is not found or crosses documents
+    std::pair<int32_t, int32_t> leaf_range_of(std::string_view pattern) const;
+
+    // documents of leaf range in ascending order
+    std::vector<int32_t> documents_of(std::pair<int32_t, int32_t> leaf_range) const;
+
+    // documents of leaf range are passed to sink in arbitrary order
+    template <typename Sink>
+    bool documents_of(std::pair<int32_t, int32_t> leaf_range, Sink&& sink) const;
+
+    static std::string concatenate(const std::vector<std::string_view>& documents);
+
+    // intersection of sorted lists, each element of smaller list is searched in larger one with galloping
+    static std::vector<int32_t> intersect(const std::vector<int32_t>& lhs, const std::vector<int32_t>& rhs);
+
+private:
+    SuffixTree<Alphabet> suffix_tree;
+    std::vector<int32_t> document_begins;
+
+    // document of suffix by lexicographic leaf number
+    std::vector<int32_t> document_array;
+
+    // previous leaf number with same document or '-1'
+    RangeMinimum previous_of_document;
+};
+
+
+template <typename Alphabet>
+std::string GeneralizedSuffixTree<Alphabet>::concatenate(const std::vector<std::string_view>& documents)
+{
+    std::string source;
+    for(std::string_view document : documents)
+    {
+        // separator must not be a part of document
+        assert(document.find(document_separator) == std::string_view::npos);
+
+        source += document;
+        source += document_separator;
+    }
+
+    return source;
+}
+
+
+template <typename Alphabet>
+GeneralizedSuffixTree<Alphabet>::GeneralizedSuffixTree(const std::vector<std::string_view>& documents)
+    : suffix_tree(concatenate(documents))
+{
+    int32_t position = 0;
+    for(std::string_view document : documents)
+    {
+        document_begins.push_back(position);
+        position += document.size() + 1;
+    }
+
+    // terminal suffix belongs to the last document
+    std::vector<int32_t> document_of_position(position + 1, std::max(documents_count() - 1, 0));
+    for(int32_t document = 0; document < documents_count(); ++document)
+    {
+        int32_t end = document + 1 < documents_count() ? document_begins[document + 1] : position;
+        std::fill(document_of_position.begin() + document_begins[document], document_of_position.begin() + end, document);
+    }
+
+    document_array.resize(suffix_tree.suffixes_count());
+    for(int32_t leaf_number = 0; leaf_number < suffix_tree.suffixes_count(); ++leaf_number)
+        document_array[leaf_number] = document_of_position[suffix_tree.suffix_at(leaf_number)];
+
+    // link each leaf with previous leaf of same document
+    std::vector<int32_t> last_leaf(documents_count() + 1, -1), previous(document_array.size());
+    for(int32_t leaf_number = 0; leaf_number < suffix_tree.suffixes_count(); ++leaf_number)
+    {
+        previous[leaf_number] = last_leaf[document_array[leaf_number]];
+        last_leaf[document_array[leaf_number]] = leaf_number;
+    }
+
+    previous_of_document = RangeMinimum(std::move(previous));
+}
+
+
+template <typename Alphabet>
+int32_t GeneralizedSuffixTree<Alphabet>::document_of(int32_t position) const
+{
+    auto next = std::upper_bound(document_begins.begin(), document_begins.end(), position);
+    return std::max<int32_t>(0, next - document_begins.begin() - 1);
+}
+
+
+template <typename Alphabet>
+std::pair<int32_t, int32_t> GeneralizedSuffixTree<Alphabet>::leaf_range_of(std::string_view pattern) const
+{
+    typename SuffixTree<Alphabet>::Cursor cursor(suffix_tree);
+
+    // empty pattern and pattern with separator doesn't belong to any document
+    bool valid = !pattern.empty() && pattern.find(document_separator) == std::string_view::npos;
+    if(!valid || cursor.extend(pattern) != pattern.size())
+    {
+        return {0, 0};
+    }
+
+    return cursor.leaf_range();
+}
+
+
+template <typename Alphabet>
+std::vector<int32_t> GeneralizedSuffixTree<Alphabet>::documents_of(std::pair<int32_t, int32_t> leaf_range) const
+{
+    std::vector<int32_t> documents;
+    documents_of(leaf_range, [&](int32_t document)
+    {
+        documents.push_back(document);
+        return true;
+    });
+
+    std::sort(documents.begin(), documents.end());
+    return documents;
+}
+
+
+template <typename Alphabet>
+template <typename Sink>
+bool GeneralizedSuffixTree<Alphabet>::documents_of(std::pair<int32_t, int32_t> leaf_range, Sink&& sink) const
+{
+    // ranges to split by leaf with minimal link, reused between queries
+    ScratchVector<std::pair<int32_t, int32_t>> ranges_scratch;
+    std::vector<std::pair<int32_t, int32_t>>& ranges = ranges_scratch.get();
+    ranges.push_back(leaf_range);
+
+    while(!ranges.empty())
+    {
+        auto [begin, end] = ranges.back();
+        ranges.pop_back();
+
+        if(begin >= end)
+            continue;
+
+        // all documents of range are already reported if minimal link is inside of leaf range
+        int32_t leaf_number = previous_of_document.index_of_min(begin, end);
+        if(previous_of_document[leaf_number] >= leaf_range.first)
+            continue;
+
+        if(!sink(document_array[leaf_number]))
+            return false;
+
+        ranges.emplace_back(begin, leaf_number);
+        ranges.emplace_back(leaf_number + 1, end);
+    }
+
+    return true;
+}
+
+
+template <typename Alphabet>
+std::vector<int32_t> GeneralizedSuffixTree<Alphabet>::find_documents(std::string_view pattern) const
+{
+    return documents_of(leaf_range_of(pattern));
+}
+
+
+template <typename Alphabet>
+template <typename Sink>
+bool GeneralizedSuffixTree<Alphabet>::find_documents(std::string_view pattern, Sink&& sink) const
+{
+    return documents_of(leaf_range_of(pattern), sink);
+}
+
+
+template <typename Alphabet>
+std::vector<int32_t> GeneralizedSuffixTree<Alphabet>::intersect(const std::vector<int32_t>& lhs, const std::vector<int32_t>& rhs)
+{
+    const std::vector<int32_t>& small = lhs.size() <= rhs.size() ? lhs : rhs;
+    const std::vector<int32_t>& large = lhs.size() <= rhs.size() ? rhs : lhs;
+
+    std::vector<int32_t> intersection;
+    auto from = large.begin();
+    for(int32_t value : small)
+    {
+        // gallop: double step until value is passed, then binary search inside last step
+        size_t step = 1;
+        auto to = from;
+        while(to != large.end() && *to < value)
+        {
+            from = to;
+            to = large.end() - to > static_cast<ptrdiff_t>(step) ? to + step : large.end();
+            step *= 2;
+        }
+
+        from = std::lower_bound(from, to, value);
+        if(from == large.end())
+            break;
+
+        if(*from == value)
+            intersection.push_back(value);
+    }
+
+    return intersection;
+}
+
+
+template <typename Alphabet>
+std::vector<int32_t> GeneralizedSuffixTree<Alphabet>::find_documents(const DocumentQuery& query) const
+{
+    std::vector<int32_t> candidates;
+
+    // required patterns from the rarest one
+    std::vector<std::pair<int32_t, int32_t>> required;
+    for(std::string_view pattern : query.all_of)
+    {
+        auto leaf_range = leaf_range_of(pattern);
+        if(leaf_range.first == leaf_range.second)
+            return candidates;
+
+        required.push_back(leaf_range);
+    }
+
+    std::sort(required.begin(), required.end(), [](const auto& lhs, const auto& rhs)
+    {
+        return lhs.second - lhs.first < rhs.second - rhs.first;
+    });
+
+    if(!required.empty())
+    {
+        candidates = documents_of(required.front());
+        for(size_t idx = 1; idx < required.size() && !candidates.empty(); ++idx)
+            candidates = intersect(candidates, documents_of(required[idx]));
+    }
+    else
+    {
+        candidates.resize(documents_count());
+        for(int32_t document = 0; document < documents_count(); ++document)
+            candidates[document] = document;
+    }
+
+    // at least one of optional patterns
+    if(!query.any_of.empty() && !candidates.empty())
+    {
+        std::vector<int32_t> any;
+        for(std::string_view pattern : query.any_of)
+        {
+            std::vector<int32_t> documents = find_documents(pattern), merged;
+            std::set_union(any.begin(), any.end(), documents.begin(), documents.end(), std::back_inserter(merged));
+            any.swap(merged);
+        }
+
+        candidates = intersect(candidates, any);
+    }
+
+    // none of excluded patterns
+    for(size_t idx = 0; idx < query.none_of.size() && !candidates.empty(); ++idx)
+    {
+        std::vector<int32_t> documents = find_documents(query.none_of[idx]), rest;
+        std::set_difference(candidates.begin(), candidates.end(), documents.begin(), documents.end(), std::back_inserter(rest));
+        candidates.swap(rest);
+    }
+
+    return candidates;
+}
+
+template <typename Alphabet>
+int32_t GeneralizedSuffixTree<Alphabet>::length_inside_document(node_reference node) const
+{
+    int32_t position = suffix_tree.is_leaf(node) ? suffix_tree.suffix_of(node) : suffix_tree.suffix_at(suffix_tree.leaf_range(node).first);
+
+    // separator follows each document
+    int32_t document = document_of(position);
+    int32_t separator = document + 1 < documents_count() ? document_begins[document + 1] - 1 : suffix_tree.suffixes_count() - 2;
+
+    return std::max(0, std::min(suffix_tree.string_depth(node), separator - position));
+}
+
+
+template <typename Alphabet>
+std::string_view GeneralizedSuffixTree<Alphabet>::longest_common_substring(int32_t first, int32_t second) const
+{
+    // bit mask of documents for each open node
+    std::vector<int32_t> masks;
+    int32_t best_length = 0, best_position = 0;
+
+    suffix_tree.traverse(suffix_tree.root(), [&](node_reference node, std::string_view)
+    {
+        masks.push_back(0);
+        if(suffix_tree.is_leaf(node))
+        {
+            int32_t document = document_of(suffix_tree.suffix_of(node));
+            masks.back() = (document == first ? 1 : 0) | (document == second ? 2 : 0);
+        }
+    },
+    [&](node_reference node)
+    {
+        int32_t mask = masks.back();
+        masks.pop_back();
+
+        if(!masks.empty())
+            masks.back() |= mask;
+
+        if(mask == 3 && !suffix_tree.is_leaf(node))
+        {
+            int32_t length = length_inside_document(node);
+            if(length > best_length)
+            {
+                best_length = length;
+                best_position = suffix_tree.suffix_at(suffix_tree.leaf_range(node).first);
+            }
+        }
+    });
+
+    return suffix_tree.text().substr(best_position, best_length);
+}
+
+
+template <typename Alphabet>
+std::vector<typename GeneralizedSuffixTree<Alphabet>::UniqueMatch> GeneralizedSuffixTree<Alphabet>::maximal_unique_matches(int32_t first, int32_t second, 
+                                                                                                                        int32_t min_length) const
+{
+    assert(first != second);
+
+    // leafs of both documents for open node, position of leaf is valid if its count is 1
+    struct Frame
+    {
+        int32_t first_count = 0;
+        int32_t second_count = 0;
+        int32_t first_position = -1;
+        int32_t second_position = -1;
+        bool unique_child = false;
+
+        // length of match from child which is cut by end of documents above child
+        int32_t pending_length = 0;
+    };
+
+    std::vector<Frame> frames;
+    std::vector<UniqueMatch> matches;
+    std::string_view text = suffix_tree.text();
+
+    auto starts_document = [&](int32_t position)
+    {
+        return position == 0 || text[position - 1] == document_separator;
+    };
+
+    suffix_tree.traverse(suffix_tree.root(), [&](node_reference node, std::string_view)
+    {
+        frames.emplace_back();
+        if(suffix_tree.is_leaf(node))
+        {
+            int32_t position = suffix_tree.suffix_of(node);
+            int32_t document = document_of(position);
+
+            Frame& frame = frames.back();
+            if(document == first)
+            {
+                frame.first_count = 1;
+                frame.first_position = position;
+            }
+            else if(document == second)
+            {
+                frame.second_count = 1;
+                frame.second_position = position;
+            }
+        }
+    },
+    [&](node_reference node)
+    {
+        Frame frame = frames.back();
+        frames.pop_back();
+
+        bool unique = frame.first_count == 1 && frame.second_count == 1;
+        if(node == suffix_tree.root())
+            return;
+
+        Frame& parent = frames.back();
+        parent.first_count += frame.first_count;
+        parent.second_count += frame.second_count;
+        parent.first_position = std::max(parent.first_position, frame.first_position);
+        parent.second_position = std::max(parent.second_position, frame.second_position);
+        parent.unique_child = parent.unique_child || unique;
+
+        // the deepest unique node is common ancestor of both leafs, so match can't be extended to the right
+        if(!unique)
+            return;
+
+        int32_t length = frame.unique_child ? frame.pending_length : length_inside_document(node);
+
+        // match cut by separator ends above node: it is unique if node where it ends is unique
+        if(length <= suffix_tree.string_depth(suffix_tree.parent(node)))
+        {
+            parent.pending_length = length;
+            return;
+        }
+
+        if(length < min_length)
+            return;
+
+        bool left_maximal = starts_document(frame.first_position) || starts_document(frame.second_position) 
+                            || text[frame.first_position - 1] != text[frame.second_position - 1];
+        if(left_maximal)
+        {
+            matches.push_back({frame.first_position - document_begins[first], frame.second_position - document_begins[second], length});
+        }
+    });
+
+    std::sort(matches.begin(), matches.end(), [](const UniqueMatch& lhs, const UniqueMatch& rhs)
+    {
+        return lhs.first_position < rhs.first_position;
+    });
+
+    return matches;
+}
+
+
+template <typename Alphabet>
+std::vector<std::string_view> GeneralizedSuffixTree<Alphabet>::longest_common_substrings(size_t threads_count) const
+{
+    // the longest substring (length, position) for each exact count of documents, per thread
+    using Best = std::vector<std::pair<int32_t, int32_t>>;
+    std::vector<Best> thread_best(std::max<size_t>(threads_count, 1), Best(documents_count() + 1, {0, 0}));
+
+    std::vector<node_reference> subtrees;
+    suffix_tree.for_each_child(suffix_tree.root(), [&](node_reference child, std::string_view)
+    {
+        subtrees.push_back(child);
+    });
+
+    parallel_for(subtrees.size(), threads_count, [&](size_t subtree_idx, size_t thread_idx)
+    {
+        Best& best = thread_best[thread_idx];
+        auto update = [&](int32_t documents, node_reference node)
+        {
+            int32_t length = length_inside_document(node);
+            if(length > best[documents].first)
+            {
+                int32_t position = suffix_tree.is_leaf(node) ? suffix_tree.suffix_of(node) : suffix_tree.suffix_at(suffix_tree.leaf_range(node).first);
+                best[documents] = {length, position};
+            }
+        };
+
+        node_reference subtree = subtrees[subtree_idx];
+        if(suffix_tree.is_leaf(subtree))
+        {
+            update(1, subtree);
+            return;
+        }
+
+        // union-find over leafs of subtree, leafs are numbered from the beginning of subtree
+        auto [leaf_begin, leaf_end] = suffix_tree.leaf_range(subtree);
+        std::vector<int32_t> parent(leaf_end - leaf_begin), ancestor(leaf_end - leaf_begin);
+
+        auto find = [&](int32_t leaf)
+        {
+            while(parent[leaf] != leaf)
+                leaf = parent[leaf] = parent[parent[leaf]];
+
+            return leaf;
+        };
+
+        // open node, 'ancestor' refers to frames by index
+        struct Frame
+        {
+            int32_t leafs;
+            int32_t duplicates;
+            int32_t representative;
+        };
+
+        std::vector<Frame> frames;
+
+        // attach set of finished subtree to open frame
+        auto attach = [&](int32_t representative, int32_t frame_idx)
+        {
+            Frame& frame = frames[frame_idx];
+            if(frame.representative == -1)
+                frame.representative = representative;
+            else
+                parent[find(representative)] = find(frame.representative);
+
+            ancestor[find(frame.representative)] = frame_idx;
+        };
+
+        int32_t leaf_number = leaf_begin;
+        suffix_tree.traverse(subtree, [&](node_reference node, std::string_view)
+        {
+            if(!suffix_tree.is_leaf(node))
+            {
+                frames.push_back({0, 0, -1});
+                return;
+            }
+
+            int32_t local = leaf_number - leaf_begin;
+            parent[local] = local;
+
+            // previous leaf of same document inside subtree has common ancestor with this leaf
+            int32_t previous = previous_of_document[leaf_number];
+            if(previous >= leaf_begin)
+                ++frames[ancestor[find(previous - leaf_begin)]].duplicates;
+
+            ++frames.back().leafs;
+            attach(local, frames.size() - 1);
+            update(1, node);
+            ++leaf_number;
+        },
+        [&](node_reference node)
+        {
+            if(suffix_tree.is_leaf(node))
+                return;
+
+            Frame frame = frames.back();
+            frames.pop_back();
+
+            update(frame.leafs - frame.duplicates, node);
+
+            if(!frames.empty())
+            {
+                frames.back().leafs += frame.leafs;
+                frames.back().duplicates += frame.duplicates;
+                attach(frame.representative, frames.size() - 1);
+            }
+        });
+    });
+
+    // merge threads and take the longest substring for at least k documents
+    std::vector<std::string_view> result(documents_count());
+    std::pair<int32_t, int32_t> longest = {0, 0};
+    for(int32_t documents = documents_count(); documents > 0; --documents)
+    {
+        for(const Best& best : thread_best)
+            if(best[documents].first > longest.first)
+                longest = best[documents];
+
+        result[documents - 1] = suffix_tree.text().substr(longest.second, longest.first);
+    }
+
+    return result;
+}
+
+} // custom
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "SuffixTree.h"
+
+namespace custom
+{
+
+// Distinct substrings of one length and histogram of their counts of occurrences.
+struct KmerSpectrum
+{
+    int32_t k;
+    int64_t distinct;
+
+    // pairs of count of occurrences and count of k-mers which occur so many times, in ascending order of the first one
+    std::vector<std::pair<int32_t, int64_t>> histogram;
+};
+
+struct KmerStatistics
+{
+    // count of distinct substrings of all lengths
+    int64_t distinct_substrings;
+
+    // spectrum of each length of requested range
+    std::vector<KmerSpectrum> spectra;
+};
+
+
+/**
+ * @brief Enumeration of k-mers with their counts
+ *
+ * Edge from node with string depth `d` to node with string depth `e` represents distinct substrings
+ * of lengths `(d, e]` (without terminal) and each of them occurs as many times as there are leafs
+ * under edge, so counts are known from annotation of tree. Subtrees deeper than `max_k` are skipped.
+ *
+ * @param tree suffix tree
+ * @param min_k minimal length of reported k-mers
+ * @param max_k maximal length of reported k-mers
+ * @param sink called as `sink(std::string_view kmer, int32_t count)` in lexicographic order (k-mer goes
+ *  before its extensions), returns false to stop enumeration
+ * @returns false if enumeration was stopped by sink
+ */
+template <typename Alphabet, typename Sink>
+bool find_kmers(const SuffixTree<Alphabet>& tree, int32_t min_k, int32_t max_k, Sink&& sink);
+
+/**
+ * @brief Count of distinct substrings and k-mer spectra in one pass
+ *
+ * Each edge gives interval of lengths with one count of occurrences. Intervals are collected in
+ * parallel over subtrees of root, counts of distinct k-mers are accumulated by difference array
+ * and histograms are made by sweep over intervals grouped by count of occurrences, so time is
+ * O(n log n + K + size of histograms) where K is size of range of lengths.
+ *
+ * @param tree suffix tree
+ * @param min_k minimal length of k-mers
+ * @param max_k maximal length of k-mers
+ * @param threads_count max count of threads
+ */
+template <typename Alphabet>
+KmerStatistics kmer_statistics(const SuffixTree<Alphabet>& tree, int32_t min_k, int32_t max_k, size_t threads_count = default_threads_count());
+
+
+namespace details
+{
+
+// lengths [first, last] of distinct substrings which occur `count` times
+struct KmerInterval
+{
+    int32_t count;
+    int32_t first;
+    int32_t last;
+};
+
+} // namespace details
+
+
+template <typename Alphabet, typename Sink>
+bool find_kmers(const SuffixTree<Alphabet>& tree, int32_t min_k, int32_t max_k, Sink&& sink)
+{
+    using node_reference = typename SuffixTree<Alphabet>::node_reference;
+    assert(0 < min_k && min_k <= max_k && "invalid range of lengths");
+
+    std::string_view text = tree.text();
+    bool stopped = false;
+
+    tree.traverse(tree.root(), [&](node_reference node, std::string_view label)
+    {
+        if(stopped)
+            return false;
+
+        // terminal is not a part of k-mers
+        int32_t depth = tree.string_depth(node) - (tree.is_leaf(node) ? 1 : 0);
+        int32_t parent_depth = tree.string_depth(node) - label.size();
+
+        auto [leaf_begin, leaf_end] = tree.is_leaf(node) ? std::pair<int32_t, int32_t>{0, 1} : tree.leaf_range(node);
+        int32_t position = tree.is_leaf(node) ? tree.suffix_of(node) : tree.suffix_at(leaf_begin);
+
+        for(int32_t k = std::max(parent_depth + 1, min_k); k <= std::min(depth, max_k) && !stopped; ++k)
+            stopped = !sink(text.substr(position, k), leaf_end - leaf_begin);
+
+        return depth < max_k;
+    },
+    [](node_reference) {});
+
+    return !stopped;
+}
+
+
+template <typename Alphabet>
+KmerStatistics kmer_statistics(const SuffixTree<Alphabet>& tree, int32_t min_k, int32_t max_k, size_t threads_count)
+{
+    using node_reference = typename SuffixTree<Alphabet>::node_reference;
+    assert(0 < min_k && min_k <= max_k && "invalid range of lengths");
+
+    std::vector<node_reference> subtrees;
+    tree.for_each_child(tree.root(), [&](node_reference child, std::string_view)
+    {
+        subtrees.push_back(child);
+    });
+
+    // intervals which intersect range and distinct substrings of each subtree
+    std::vector<std::vector<details::KmerInterval>> subtree_intervals(subtrees.size());
+    std::vector<int64_t> subtree_distinct(subtrees.size(), 0);
+
+    parallel_for(subtrees.size(), threads_count, [&](size_t subtree_idx, size_t)
+    {
+        auto add_edge = [&](node_reference node, int32_t parent_depth)
+        {
+            int32_t depth = tree.string_depth(node) - (tree.is_leaf(node) ? 1 : 0);
+            subtree_distinct[subtree_idx] += std::max(0, depth - parent_depth);
+
+            int32_t first = std::max(parent_depth + 1, min_k), last = std::min(depth, max_k);
+            if(first > last)
+                return;
+
+            auto [leaf_begin, leaf_end] = tree.is_leaf(node) ? std::pair<int32_t, int32_t>{0, 1} : tree.leaf_range(node);
+            subtree_intervals[subtree_idx].push_back({leaf_end - leaf_begin, first, last});
+        };
+
+        add_edge(subtrees[subtree_idx], 0);
+        if(tree.is_leaf(subtrees[subtree_idx]))
+            return;
+
+        // label of subtree's root is not passed to traversal
+        tree.traverse(subtrees[subtree_idx], [&](node_reference node, std::string_view label)
+        {
+            if(node != subtrees[subtree_idx])
+                add_edge(node, tree.string_depth(node) - label.size());
+        },
+        [](node_reference) {});
+    });
+
+    KmerStatistics statistics{0, {}};
+    std::vector<details::KmerInterval> intervals;
+    for(size_t subtree_idx = 0; subtree_idx < subtrees.size(); ++subtree_idx)
+    {
+        statistics.distinct_substrings += subtree_distinct[subtree_idx];
+        intervals.insert(intervals.end(), subtree_intervals[subtree_idx].begin(), subtree_intervals[subtree_idx].end());
+        std::vector<details::KmerInterval>().swap(subtree_intervals[subtree_idx]);
+    }
+
+    // distinct k-mers by difference array over lengths
+    std::vector<int64_t> distinct(max_k - min_k + 2, 0);
+    for(const details::KmerInterval& interval : intervals)
+    {
+        distinct[interval.first - min_k] += 1;
+        distinct[interval.last - min_k + 1] -= 1;
+    }
+
+    statistics.spectra.resize(max_k - min_k + 1);
+    for(int32_t k = min_k; k <= max_k; ++k)
+    {
+        KmerSpectrum& spectrum = statistics.spectra[k - min_k];
+        spectrum.k = k;
+        spectrum.distinct = (k == min_k ? 0 : statistics.spectra[k - min_k - 1].distinct) + distinct[k - min_k];
+    }
+
+    // intervals with equal count of occurrences are swept in order of their bounds
+    std::sort(intervals.begin(), intervals.end(), [](const details::KmerInterval& lhs, const details::KmerInterval& rhs)
+    {
+        return lhs.count != rhs.count ? lhs.count < rhs.count : lhs.first < rhs.first;
+    });
+
+    std::vector<std::pair<int32_t, int32_t>> bounds;
+    for(size_t group_begin = 0, group_end = 0; group_begin < intervals.size(); group_begin = group_end)
+    {
+        int32_t count = intervals[group_begin].count;
+
+        bounds.clear();
+        for(group_end = group_begin; group_end < intervals.size() && intervals[group_end].count == count; ++group_end)
+        {
+            bounds.emplace_back(intervals[group_end].first, 1);
+            bounds.emplace_back(intervals[group_end].last + 1, -1);
+        }
+
+        std::sort(bounds.begin(), bounds.end());
+
+        // count of intervals which cover lengths between neighbour bounds
+        int64_t covered = 0;
+        for(size_t idx = 0; idx + 1 < bounds.size(); ++idx)
+        {
+            covered += bounds[idx].second;
+            for(int32_t k = bounds[idx].first; covered > 0 && k < bounds[idx + 1].first; ++k)
+                statistics.spectra[k - min_k].histogram.emplace_back(count, covered);
+        }
+    }
+
+    return statistics;
+}
+
+} // custom
@@ -0,0 +1,203 @@
+#pragma once
+
+#include "SuffixTree.h"
+
+namespace custom
+{
+
+/**
+ * @brief Token of LZ77 factorization
+ *
+ * Decoder copies `length` letters which start `offset` letters before end of decoded string (copy
+ * could overlap with itself) and then appends `literal`. Token without copy has zero offset and length.
+ */
+struct Lz77Token
+{
+    int32_t offset;
+    int32_t length;
+    char literal;
+};
+
+
+/**
+ * @brief LZ77 factorization of source
+ *
+ * Each factor is the longest prefix of rest of source which also starts earlier, followed by one
+ * literal. Edges of Ukkonen's tree keep position of the first occurrence of their substrings, so
+ * cursor descends from the root while the first occurrence of matched substring is before current
+ * position, each letter costs O(1) and whole factorization is O(n). The last factor is shortened by
+ * one letter if it reaches end of source, so each token has a literal.
+ *
+ * @param tree suffix tree
+ * @param sink called as `sink(const Lz77Token&)` in order of source, returns false to stop factorization
+ * @returns false if factorization was stopped by sink
+ */
+template <typename Alphabet, typename Sink>
+bool lz77_factorize(const SuffixTree<Alphabet>& tree, Sink&& sink);
+
+// Same as above, but tokens are returned in order of source.
+template <typename Alphabet>
+std::vector<Lz77Token> lz77_factorize(const SuffixTree<Alphabet>& tree);
+
+/**
+ * @brief Longest previous factor array
+ *
+ * For each position `i` of source writes length of the longest substring which starts at `i` and also
+ * starts earlier. In post-order pass each node keeps the minimal position of its leafs; leaf `i` gets
+ * string depth of the lowest node where it stops to be the minimal one, because all leafs of the node
+ * share prefix of that length and the earlier one is there. Subtrees of root are processed in
+ * parallel, array is written without temporaries, so it could be mapped to file. Time is O(n).
+ *
+ * @param tree suffix tree
+ * @param lpf caller-provided array of size of source (without terminal)
+ * @param threads_count max count of threads
+ */
+template <typename Alphabet>
+void longest_previous_factors(const SuffixTree<Alphabet>& tree, int32_t* lpf, size_t threads_count = default_threads_count());
+
+// Appends letters of token to decoded string, so tokens could be decoded as they are produced.
+inline void lz77_decode(const Lz77Token& token, std::string& output);
+
+// Decodes all tokens of factorization.
+inline std::string lz77_decode(const std::vector<Lz77Token>& tokens);
+
+
+template <typename Alphabet, typename Sink>
+bool lz77_factorize(const SuffixTree<Alphabet>& tree, Sink&& sink)
+{
+    std::string_view text = tree.text();
+
+    // terminal is not a part of source
+    int32_t text_size = tree.suffixes_count() - 1;
+    for(int32_t position = 0; position < text_size; )
+    {
+        // the first occurrence never moves back when substring grows
+        typename SuffixTree<Alphabet>::Cursor cursor(tree);
+        while(position + cursor.length() + 1 < text_size && cursor.extend(text[position + cursor.length()]))
+        {
+            if(cursor.first_position() >= position)
+            {
+                cursor.retract();
+                break;
+            }
+        }
+
+        int32_t length = cursor.length();
+        int32_t offset = length == 0 ? 0 : position - cursor.first_position();
+        if(!sink(Lz77Token{offset, length, text[position + length]}))
+            return false;
+
+        position += length + 1;
+    }
+
+    return true;
+}
+
+
+template <typename Alphabet>
+std::vector<Lz77Token> lz77_factorize(const SuffixTree<Alphabet>& tree)
+{
+    std::vector<Lz77Token> tokens;
+    lz77_factorize(tree, [&](const Lz77Token& token)
+    {
+        tokens.push_back(token);
+        return true;
+    });
+
+    return tokens;
+}
+
+
+template <typename Alphabet>
+void longest_previous_factors(const SuffixTree<Alphabet>& tree, int32_t* lpf, size_t threads_count)
+{
+    using node_reference = typename SuffixTree<Alphabet>::node_reference;
+
+    // terminal is not a part of source
+    int32_t text_size = tree.suffixes_count() - 1;
+
+    std::vector<node_reference> subtrees;
+    tree.for_each_child(tree.root(), [&](node_reference child, std::string_view)
+    {
+        subtrees.push_back(child);
+    });
+
+    parallel_for(subtrees.size(), threads_count, [&](size_t subtree_idx, size_t)
+    {
+        // minimal leaf position and string depth of each open inner node
+        std::vector<std::pair<int32_t, int32_t>> frames;
+
+        // leaf which isn't minimal in node has earlier occurrence of node's string
+        auto merge = [&](int32_t position)
+        {
+            if(frames.empty())
+            {
+                // the first occurrence of letter, terminal has no entry
+                if(position < text_size)
+                    lpf[position] = 0;
+
+                return;
+            }
+
+            auto& [minimal, depth] = frames.back();
+            if(position < minimal)
+                std::swap(position, minimal);
+
+            if(position != std::numeric_limits<int32_t>::max())
+                lpf[position] = depth;
+        };
+
+        if(tree.is_leaf(subtrees[subtree_idx]))
+        {
+            merge(tree.suffix_of(subtrees[subtree_idx]));
+            return;
+        }
+
+        tree.traverse(subtrees[subtree_idx], [&](node_reference node, std::string_view)
+        {
+            if(tree.is_leaf(node))
+                return false;
+
+            frames.emplace_back(std::numeric_limits<int32_t>::max(), tree.string_depth(node));
+            return true;
+        },
+        [&](node_reference node)
+        {
+            if(tree.is_leaf(node))
+            {
+                merge(tree.suffix_of(node));
+                return;
+            }
+
+            int32_t minimal = frames.back().first;
+            frames.pop_back();
+            merge(minimal);
+        });
+    });
+}
+
+
+inline void lz77_decode(const Lz77Token& token, std::string& output)
+{
+    assert(token.offset >= 0 && token.offset <= static_cast<int32_t>(output.size()) && "offset is out of decoded string");
+    assert((token.offset > 0 || token.length == 0) && "copy without offset");
+
+    // letters are copied one by one, because copy could overlap with itself
+    size_t source = output.size() - token.offset;
+    for(int32_t idx = 0; idx < token.length; ++idx)
+        output.push_back(output[source + idx]);
+
+    output.push_back(token.literal);
+}
+
+
+inline std::string lz77_decode(const std::vector<Lz77Token>& tokens)
+{
+    std::string output;
+    for(const Lz77Token& token : tokens)
+        lz77_decode(token, output);
+
+    return output;
+}
+
+} // custom
@@ -0,0 +1,216 @@
+#pragma once
+
+#include "SuffixTree.h"
+#include "RangeMinimum.h"
+
+namespace custom
+{
+
+/**
+ * @brief Lowest common ancestors and longest common extensions in constant time
+ *
+ * Tree is written as Euler tour: node is written when it is entered and each time when traversal
+ * returns to it from child. String depth strictly grows from parent to child, so the lowest common
+ * ancestor of two nodes is the node with minimal string depth between their first occurrences in
+ * tour, which is found by constant time range minimum. Longest common extension of two suffixes
+ * is string depth of lowest common ancestor of their leafs. Tours of subtrees of root are written
+ * in parallel. Memory is O(n) words.
+ */
+template <typename Alphabet=StandartSuffixTreeAlphabet>
+class LongestCommonExtension
+{
+public:
+    using node_reference = typename SuffixTree<Alphabet>::node_reference;
+
+public:
+    /**
+     * @param tree suffix tree which must outlive index
+     * @param threads_count max count of threads for preprocessing
+     */
+    LongestCommonExtension(const SuffixTree<Alphabet>& tree, size_t threads_count = default_threads_count());
+
+    // Lowest common ancestor of two nodes, inner or leafs.
+    node_reference lowest_common_ancestor(node_reference first, node_reference second) const;
+
+    // Length of common prefix of suffixes which start from positions of source.
+    int32_t longest_common_extension(int32_t first, int32_t second) const;
+
+    /**
+     * @brief Longest common extensions of batch of pairs of positions
+     *
+     * @param pairs positions of suffixes
+     * @param threads_count max count of threads
+     * @returns extension of each pair
+     */
+    std::vector<int32_t> longest_common_extensions(const std::vector<std::pair<int32_t, int32_t>>& pairs,
+                                                   size_t threads_count = default_threads_count()) const;
+
+    /**
+     * @brief Lexicographic comparison of substrings in constant time
+     *
+     * Letters are ordered as in alphabet.
+     *
+     * @returns negative value if first substring is less, zero if substrings are equal and positive value otherwise
+     */
+    int32_t compare(int32_t first, int32_t first_length, int32_t second, int32_t second_length) const;
+
+private:
+    // index of first occurrence of node in tour
+    int32_t first_occurrence(node_reference node) const;
+
+private:
+    static inline constexpr Alphabet alphabet{};
+
+    const SuffixTree<Alphabet>& tree;
+
+    // nodes of tour and their string depths
+    std::vector<node_reference> tour;
+    RangeMinimum depths;
+
+    // first occurrences in tour by references of inner nodes and by positions of leafs
+    std::vector<int32_t> first_of_node;
+    std::vector<int32_t> first_of_leaf;
+};
+
+
+template <typename Alphabet>
+LongestCommonExtension<Alphabet>::LongestCommonExtension(const SuffixTree<Alphabet>& tree, size_t threads_count) : tree(tree)
+{
+    std::vector<node_reference> subtrees;
+    tree.for_each_child(tree.root(), [&](node_reference child, std::string_view)
+    {
+        subtrees.push_back(child);
+    });
+
+    // tour of each subtree of root without root
+    std::vector<std::vector<node_reference>> subtree_tours(subtrees.size());
+    parallel_for(subtrees.size(), threads_count, [&](size_t subtree_idx, size_t)
+    {
+        std::vector<node_reference>& subtree_tour = subtree_tours[subtree_idx];
+        if(tree.is_leaf(subtrees[subtree_idx]))
+        {
+            subtree_tour.push_back(subtrees[subtree_idx]);
+            return;
+        }
+
+        std::vector<node_reference> open;
+        tree.traverse(subtrees[subtree_idx], [&](node_reference node, std::string_view)
+        {
+            subtree_tour.push_back(node);
+            open.push_back(node);
+        },
+        [&](node_reference)
+        {
+            open.pop_back();
+            if(!open.empty())
+                subtree_tour.push_back(open.back());
+        });
+    });
+
+    // root is written before each subtree and after the last one
+    std::vector<size_t> offsets(subtrees.size() + 1, 1);
+    for(size_t subtree_idx = 0; subtree_idx < subtrees.size(); ++subtree_idx)
+        offsets[subtree_idx + 1] = offsets[subtree_idx] + subtree_tours[subtree_idx].size() + 1;
+
+    tour.resize(offsets.back());
+    std::vector<int32_t> tour_depths(tour.size());
+    first_of_node.assign(tree.nodes_count(), -1);
+    first_of_leaf.assign(tree.suffixes_count(), -1);
+
+    tour[0] = tree.root();
+    first_of_node[tree.root()] = 0;
+
+    parallel_for(subtrees.size(), threads_count, [&](size_t subtree_idx, size_t)
+    {
+        const std::vector<node_reference>& subtree_tour = subtree_tours[subtree_idx];
+        for(size_t idx = 0; idx < subtree_tour.size(); ++idx)
+        {
+            node_reference node = subtree_tour[idx];
+            int32_t position = offsets[subtree_idx] + idx;
+
+            tour[position] = node;
+            tour_depths[position] = tree.string_depth(node);
+
+            // subtrees are disjoint, so each first occurrence is written by one thread
+            int32_t& first = tree.is_leaf(node) ? first_of_leaf[tree.suffix_of(node)] : first_of_node[node];
+            if(first == -1)
+                first = position;
+        }
+
+        tour[offsets[subtree_idx + 1] - 1] = tree.root();
+        std::vector<node_reference>().swap(subtree_tours[subtree_idx]);
+    });
+
+    depths = RangeMinimum(std::move(tour_depths));
+}
+
+
+template <typename Alphabet>
+int32_t LongestCommonExtension<Alphabet>::first_occurrence(node_reference node) const
+{
+    return tree.is_leaf(node) ? first_of_leaf[tree.suffix_of(node)] : first_of_node[node];
+}
+
+
+template <typename Alphabet>
+typename LongestCommonExtension<Alphabet>::node_reference LongestCommonExtension<Alphabet>::lowest_common_ancestor(node_reference first,
+                                                                                                                  node_reference second) const
+{
+    int32_t first_idx = first_occurrence(first), second_idx = first_occurrence(second);
+    if(first_idx > second_idx)
+        std::swap(first_idx, second_idx);
+
+    return tour[depths.index_of_min(first_idx, second_idx + 1)];
+}
+
+
+template <typename Alphabet>
+int32_t LongestCommonExtension<Alphabet>::longest_common_extension(int32_t first, int32_t second) const
+{
+    // terminal is not a part of source
+    int32_t text_size = tree.suffixes_count() - 1;
+    if(first == second)
+    {
+        return text_size - first;
+    }
+
+    int32_t first_idx = first_of_leaf[first], second_idx = first_of_leaf[second];
+    if(first_idx > second_idx)
+        std::swap(first_idx, second_idx);
+
+    return depths[depths.index_of_min(first_idx, second_idx + 1)];
+}
+
+
+template <typename Alphabet>
+std::vector<int32_t> LongestCommonExtension<Alphabet>::longest_common_extensions(const std::vector<std::pair<int32_t, int32_t>>& pairs,
+                                                                                 size_t threads_count) const
+{
+    // chunks smaller than this are not worth of thread synchronisation
+    static constexpr size_t chunk_size = 1 << 14;
+
+    std::vector<int32_t> extensions(pairs.size());
+    parallel_for((pairs.size() + chunk_size - 1) / chunk_size, threads_count, [&](size_t chunk_idx, size_t)
+    {
+        for(size_t idx = chunk_idx * chunk_size; idx < std::min(pairs.size(), (chunk_idx + 1) * chunk_size); ++idx)
+            extensions[idx] = longest_common_extension(pairs[idx].first, pairs[idx].second);
+    });
+
+    return extensions;
+}
+
+
+template <typename Alphabet>
+int32_t LongestCommonExtension<Alphabet>::compare(int32_t first, int32_t first_length, int32_t second, int32_t second_length) const
+{
+    int32_t common = std::min({longest_common_extension(first, second), first_length, second_length});
+    if(common == first_length || common == second_length)
+    {
+        return first_length - second_length;
+    }
+
+    std::string_view text = tree.text();
+    return alphabet.index_of(text[first + common]) - alphabet.index_of(text[second + common]);
+}
+
+} // custom
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+
+namespace custom
+{
+
+/**
+ * @brief Sink which writes query results into caller-provided buffer
+ *
+ * Multi-result queries report results to callable sink one by one and stop when sink returns
+ * false. This adapter allows to get results without any allocation: query stops as soon as
+ * buffer is full and buffer remembers that results were truncated.
+ */
+template <typename T>
+class OutputBuffer
+{
+public:
+    OutputBuffer(T* data, size_t capacity) : data(data), capacity(capacity) {}
+
+    bool operator()(const T& value)
+    {
+        if(written == capacity)
+        {
+            truncated = true;
+            return false;
+        }
+
+        data[written++] = value;
+        return true;
+    }
+
+    // Count of written values.
+    size_t size() const { return written; }
+
+    // Checks were some values dropped due to lack of space.
+    bool is_truncated() const { return truncated; }
+
+    // Allows to reuse buffer for next query.
+    void clear() { written = 0; truncated = false; }
+
+private:
+    T* data;
+    size_t capacity;
+    size_t written = 0;
+    bool truncated = false;
+};
+
+} // namespace custom
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+namespace custom
+{
+
+// Count of threads used by parallel algorithms if caller doesn't define it.
+inline size_t default_threads_count()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * @brief Parallel loop over independent tasks
+ *
+ * Tasks are numbered from 0 to `tasks_count - 1` and taken by threads one by one from shared
+ * counter, so threads which got cheap tasks take more of them and uneven tasks are balanced.
+ * Calling thread participates in work too.
+ *
+ * @param tasks_count count of tasks
+ * @param threads_count max count of threads, including calling one
+ * @param task callable `task(size_t task_idx, size_t thread_idx)`
+ */
+template <typename Task>
+void parallel_for(size_t tasks_count, size_t threads_count, Task&& task)
+{
+    threads_count = std::max<size_t>(1, std::min(threads_count, tasks_count));
+
+    std::atomic<size_t> next_task{0};
+    auto worker = [&](size_t thread_idx)
+    {
+        for(size_t task_idx = next_task++; task_idx < tasks_count; task_idx = next_task++)
+            task(task_idx, thread_idx);
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threads_count - 1);
+    for(size_t thread_idx = 1; thread_idx < threads_count; ++thread_idx)
+        threads.emplace_back(worker, thread_idx);
+
+    worker(0);
+
+    for(std::thread& thread : threads)
+        thread.join();
+}
+
+} // namespace custom
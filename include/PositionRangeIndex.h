@@ -0,0 +1,208 @@
+#pragma once
+
+#include "SuffixTree.h"
+#include "WaveletMatrix.h"
+
+namespace custom
+{
+
+/**
+ * @brief Occurrence queries restricted to range of source positions
+ *
+ * Occurrences of pattern are leafs of contiguous range of lexicographic leaf numbers, so wavelet
+ * matrix over start positions of suffixes in leaf order allows to select occurrences by position
+ * without enumeration of all of them. Index refers to tree, so tree must outlive it.
+ */
+template <typename Alphabet=StandartSuffixTreeAlphabet>
+class PositionRangeIndex
+{
+public:
+    PositionRangeIndex(const SuffixTree<Alphabet>& tree);
+
+    /**
+     * @brief Substring matching inside range
+     *
+     * @param pattern string to match as substring
+     * @param begin, end range of source [begin, end), occurrence must lie inside range entirely
+     * @returns true if pattern is found inside range and false otherwise
+     */
+    bool contains(std::string_view pattern, int32_t begin, int32_t end) const { return count(pattern, begin, end) != 0; }
+
+    // Count of occurrences which lie inside range [begin, end) with O(m + log n) time complexity.
+    int32_t count(std::string_view pattern, int32_t begin, int32_t end) const;
+
+    // Positions of occurrences which lie inside range [begin, end) in ascending order.
+    std::vector<int32_t> find_all(std::string_view pattern, int32_t begin, int32_t end) const;
+
+    // Positions are passed to `sink(int32_t)` which returns false to stop query, returns false if stopped by sink.
+    template <typename Sink>
+    bool find_all(std::string_view pattern, int32_t begin, int32_t end, Sink&& sink) const;
+
+    /**
+     * @brief Proximity search
+     * 
+     * Finds pairs of occurrences where `second` starts not later than `distance` letters after end of 
+     * `first`. Occurrences of the rarer pattern drive search and occurrences of other one are selected 
+     * by position range, so occurrences which have no close pair are never enumerated.
+     * 
+     * @param first, second patterns
+     * @param distance max count of letters between occurrences
+     * @param ordered if false pairs where `first` follows `second` are reported too
+     * @returns pairs of positions of `first` and `second` occurrences in arbitrary order
+     */
+    std::vector<std::pair<int32_t, int32_t>> find_near(std::string_view first, std::string_view second, int32_t distance, bool ordered = true) const;
+
+    // Pairs of positions are passed to `sink(int32_t, int32_t)` which returns false to stop query, returns false if stopped by sink.
+    template <typename Sink>
+    bool find_near(std::string_view first, std::string_view second, int32_t distance, bool ordered, Sink&& sink) const;
+
+private:
+    // leaf range of pattern and interval of allowed start positions
+    struct Query
+    {
+        int32_t leaf_begin = 0;
+        int32_t leaf_end = 0;
+        int32_t low = 0;
+        int32_t high = 0;
+    };
+
+    Query prepare(std::string_view pattern, int32_t begin, int32_t end) const;
+
+    // bound of interval of start positions which is computed without overflow and clamped to [0, n]
+    int32_t clamp_position(int64_t position) const { return std::clamp<int64_t>(position, 0, tree.suffixes_count()); }
+
+private:
+    const SuffixTree<Alphabet>& tree;
+
+    // start positions of suffixes in lexicographic leaf order
+    WaveletMatrix positions;
+};
+
+
+template <typename Alphabet>
+PositionRangeIndex<Alphabet>::PositionRangeIndex(const SuffixTree<Alphabet>& tree) : tree(tree)
+{
+    std::vector<int32_t> suffixes(tree.suffixes_count());
+    for(int32_t leaf_number = 0; leaf_number < tree.suffixes_count(); ++leaf_number)
+        suffixes[leaf_number] = tree.suffix_at(leaf_number);
+
+    positions = WaveletMatrix(suffixes);
+}
+
+
+template <typename Alphabet>
+typename PositionRangeIndex<Alphabet>::Query PositionRangeIndex<Alphabet>::prepare(std::string_view pattern, int32_t begin, int32_t end) const
+{
+    typename SuffixTree<Alphabet>::Cursor cursor(tree);
+    if(cursor.extend(pattern) != pattern.size())
+    {
+        return {};
+    }
+
+    auto [leaf_begin, leaf_end] = cursor.leaf_range();
+
+    // occurrence which starts in 'position' ends in 'position + m'
+    int64_t last_start = static_cast<int64_t>(end) - static_cast<int64_t>(pattern.size()) + 1;
+    return {leaf_begin, leaf_end, clamp_position(begin), clamp_position(last_start)};
+}
+
+
+template <typename Alphabet>
+int32_t PositionRangeIndex<Alphabet>::count(std::string_view pattern, int32_t begin, int32_t end) const
+{
+    Query query = prepare(pattern, begin, end);
+    return positions.count(query.leaf_begin, query.leaf_end, query.low, query.high);
+}
+
+
+template <typename Alphabet>
+std::vector<int32_t> PositionRangeIndex<Alphabet>::find_all(std::string_view pattern, int32_t begin, int32_t end) const
+{
+    std::vector<int32_t> occurrences;
+    find_all(pattern, begin, end, [&](int32_t position)
+    {
+        occurrences.push_back(position);
+        return true;
+    });
+
+    return occurrences;
+}
+
+
+template <typename Alphabet>
+template <typename Sink>
+bool PositionRangeIndex<Alphabet>::find_all(std::string_view pattern, int32_t begin, int32_t end, Sink&& sink) const
+{
+    Query query = prepare(pattern, begin, end);
+    return positions.for_each(query.leaf_begin, query.leaf_end, query.low, query.high, sink);
+}
+
+
+template <typename Alphabet>
+std::vector<std::pair<int32_t, int32_t>> PositionRangeIndex<Alphabet>::find_near(std::string_view first, std::string_view second, 
+                                                                                  int32_t distance, bool ordered) const
+{
+    std::vector<std::pair<int32_t, int32_t>> pairs;
+    find_near(first, second, distance, ordered, [&](int32_t first_position, int32_t second_position)
+    {
+        pairs.emplace_back(first_position, second_position);
+        return true;
+    });
+
+    return pairs;
+}
+
+
+template <typename Alphabet>
+template <typename Sink>
+bool PositionRangeIndex<Alphabet>::find_near(std::string_view first, std::string_view second, int32_t distance, bool ordered, Sink&& sink) const
+{
+    Query first_query = prepare(first, 0, 0), second_query = prepare(second, 0, 0);
+
+    int32_t first_count = first_query.leaf_end - first_query.leaf_begin;
+    int32_t second_count = second_query.leaf_end - second_query.leaf_begin;
+    if(first_count == 0 || second_count == 0 || distance < 0)
+    {
+        return true;
+    }
+
+    int32_t first_length = first.size(), second_length = second.size();
+
+    // enumerate occurrences of the rarer pattern and select close occurrences of other one
+    bool driven_by_first = first_count <= second_count;
+    const Query& driver = driven_by_first ? first_query : second_query;
+    const Query& probe = driven_by_first ? second_query : first_query;
+
+    for(int32_t leaf_number = driver.leaf_begin; leaf_number < driver.leaf_end; ++leaf_number)
+    {
+        int32_t position = tree.suffix_at(leaf_number);
+
+        auto report = [&](int32_t probe_position)
+        {
+            return driven_by_first ? sink(position, probe_position) : sink(probe_position, position);
+        };
+
+        // start of `second` is in [end of `first`, end of `first` + distance]
+        int64_t low = driven_by_first ? static_cast<int64_t>(position) + first_length : static_cast<int64_t>(position) - distance - first_length;
+        if(!positions.for_each(probe.leaf_begin, probe.leaf_end, clamp_position(low), clamp_position(low + distance + 1), report))
+            return false;
+
+        if(ordered)
+            continue;
+
+        // pair of empty patterns at the same position is in both windows
+        auto report_once = [&](int32_t probe_position)
+        {
+            return (first_length + second_length == 0 && probe_position == position) || report(probe_position);
+        };
+
+        // start of `first` is in [end of `second`, end of `second` + distance]
+        low = driven_by_first ? static_cast<int64_t>(position) - distance - second_length : static_cast<int64_t>(position) + second_length;
+        if(!positions.for_each(probe.leaf_begin, probe.leaf_end, clamp_position(low), clamp_position(low + distance + 1), report_once))
+            return false;
+    }
+
+    return true;
+}
+
+} // custom
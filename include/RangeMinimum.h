@@ -0,0 +1,129 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include <cassert>
+
+namespace custom
+{
+
+/**
+ * @brief Range minimum queries in constant time
+ *
+ * Sequence is split to blocks of 64 values. Minimums of whole blocks are kept in sparse table and
+ * inside block each position keeps bit mask of positions which are minimums of ranges ending in it
+ * (monotone stack of block's prefix), so minimum of any range inside block is the lowest bit of mask.
+ * Extra memory is O(n) words.
+ */
+class RangeMinimum
+{
+public:
+    RangeMinimum() = default;
+    RangeMinimum(std::vector<int32_t> values);
+
+    // Position of the leftmost minimum in non-empty range [begin, end).
+    int32_t index_of_min(int32_t begin, int32_t end) const;
+
+    int32_t operator[](int32_t position) const { return values[position]; }
+
+    int32_t size() const { return values.size(); }
+
+private:
+    static constexpr int32_t block_size = 64;
+
+    // position of the leftmost minimum in range [first, last] inside one block
+    int32_t index_of_min_in_block(int32_t first, int32_t last) const;
+
+    // position of minimum between two positions, the leftmost for equal values
+    int32_t min_of(int32_t lhs, int32_t rhs) const;
+
+private:
+    std::vector<int32_t> values;
+    std::vector<uint64_t> masks;
+
+    // sparse_table[level][block] is position of minimum of 2^level blocks starting from block
+    std::vector<std::vector<int32_t>> sparse_table;
+};
+
+
+inline RangeMinimum::RangeMinimum(std::vector<int32_t> source) : values(std::move(source)), masks(values.size())
+{
+    int32_t blocks_count = (size() + block_size - 1) / block_size;
+    sparse_table.emplace_back(blocks_count);
+
+    // monotone stack of each block is kept as bit mask
+    for(int32_t block = 0; block < blocks_count; ++block)
+    {
+        int32_t first = block * block_size;
+        uint64_t stack = 0;
+
+        for(int32_t position = first; position < std::min(size(), first + block_size); ++position)
+        {
+            while(stack != 0 && values[first + 63 - __builtin_clzll(stack)] > values[position])
+                stack ^= uint64_t(1) << (63 - __builtin_clzll(stack));
+
+            stack |= uint64_t(1) << (position - first);
+            masks[position] = stack;
+        }
+
+        sparse_table[0][block] = first + __builtin_ctzll(stack);
+    }
+
+    for(int32_t level = 1; (1 << level) <= blocks_count; ++level)
+    {
+        const std::vector<int32_t>& previous = sparse_table[level - 1];
+        std::vector<int32_t> current(blocks_count - (1 << level) + 1);
+
+        for(size_t block = 0; block < current.size(); ++block)
+            current[block] = min_of(previous[block], previous[block + (1 << (level - 1))]);
+
+        sparse_table.push_back(std::move(current));
+    }
+}
+
+
+inline int32_t RangeMinimum::min_of(int32_t lhs, int32_t rhs) const
+{
+    if(values[lhs] != values[rhs])
+        return values[lhs] < values[rhs] ? lhs : rhs;
+
+    return std::min(lhs, rhs);
+}
+
+
+inline int32_t RangeMinimum::index_of_min_in_block(int32_t first, int32_t last) const
+{
+    int32_t block_begin = first - first % block_size;
+    uint64_t mask = masks[last] & (~uint64_t(0) << (first - block_begin));
+    return block_begin + __builtin_ctzll(mask);
+}
+
+
+inline int32_t RangeMinimum::index_of_min(int32_t begin, int32_t end) const
+{
+    assert(begin < end);
+
+    int32_t last = end - 1;
+    int32_t first_block = begin / block_size, last_block = last / block_size;
+    if(first_block == last_block)
+    {
+        return index_of_min_in_block(begin, last);
+    }
+
+    int32_t result = min_of(index_of_min_in_block(begin, first_block * block_size + block_size - 1),
+                            index_of_min_in_block(last_block * block_size, last));
+
+    // whole blocks between
+    if(first_block + 1 < last_block)
+    {
+        int32_t from = first_block + 1, blocks = last_block - from;
+        int32_t level = 31 - __builtin_clz(blocks);
+        result = min_of(result, min_of(sparse_table[level][from], sparse_table[level][last_block - (1 << level)]));
+    }
+
+    return result;
+}
+
+} // namespace custom
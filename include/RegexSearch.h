@@ -0,0 +1,479 @@
+#pragma once
+
+#include "WildcardSearch.h"
+
+#include <map>
+
+namespace custom
+{
+
+/**
+ * @brief Regular expression compiled to automaton over indices of alphabet
+ *
+ * Syntax: letters, `.` (any letter), classes `[...]` (see `WildcardPattern`), groups `(...)`,
+ * alternation `|`, repetitions `*`, `+`, `?` and escapes `\`. Expression is parsed to Thompson's
+ * NFA, DFA is built from it lazily by subset construction, so only states which are met by search
+ * are created. DFA is owned by caller (see `Automaton`), so compiled expression is immutable and
+ * could be shared by parallel queries.
+ */
+template <typename Alphabet=StandartSuffixTreeAlphabet>
+class Regex
+{
+public:
+    using LetterSet = typename WildcardPattern<Alphabet>::LetterSet;
+
+    // State of DFA without way to accepting state.
+    static constexpr int32_t dead_state = -1;
+
+    // Lazily built DFA of expression which must outlive it, one object must not be used by several threads at once.
+    class Automaton
+    {
+    public:
+        explicit Automaton(const Regex& regex);
+
+        // Initial state of DFA.
+        int32_t start() const { return start_state; }
+
+        // State of DFA after letter, `dead_state` if letter can't continue match.
+        int32_t next(int32_t state, char ch);
+
+        // Checks is string read to state matched by expression.
+        bool is_accepting(int32_t state) const { return accepting[state]; }
+
+        // Expression of automaton.
+        const Regex& expression() const { return regex; }
+
+    private:
+        // DFA state of set of NFA states closed by epsilon transitions
+        int32_t state_of(std::vector<int32_t> nfa_states);
+
+    private:
+        const Regex& regex;
+
+        // transitions[state * size of alphabet + index of letter], '-2' means unknown yet
+        std::map<std::vector<int32_t>, int32_t> states;
+        std::vector<std::vector<int32_t>> sets;
+        std::vector<int32_t> transitions;
+        std::vector<bool> accepting;
+        int32_t start_state;
+    };
+
+public:
+    Regex(std::string_view pattern);
+
+    // The longest string which occurs in each match of expression.
+    const std::string& required_literal() const { return required; }
+
+private:
+    // transition of NFA by letter to 'next' and epsilon transitions
+    struct NfaState
+    {
+        LetterSet letters;
+        int32_t next = -1;
+        std::vector<int32_t> epsilons;
+    };
+
+    // part of NFA from 'start' to 'end' and literals of strings it matches
+    struct Fragment
+    {
+        int32_t start;
+        int32_t end;
+
+        // is set if fragment matches exactly one string: 'exact'
+        bool is_exact;
+        std::string exact;
+
+        // each match of fragment starts with 'prefix', ends with 'suffix' and contains 'required'
+        std::string prefix;
+        std::string suffix;
+        std::string required;
+    };
+
+    Fragment parse_alternation(std::string_view pattern, size_t& idx);
+    Fragment parse_concatenation(std::string_view pattern, size_t& idx);
+    Fragment parse_repetition(std::string_view pattern, size_t& idx);
+    Fragment parse_atom(std::string_view pattern, size_t& idx);
+
+    int32_t add_state();
+    Fragment empty_fragment();
+    Fragment letters_fragment(const LetterSet& letters);
+
+private:
+    static inline constexpr Alphabet alphabet{};
+
+    std::vector<NfaState> nfa;
+    int32_t nfa_start;
+    int32_t nfa_accept;
+    std::string required;
+};
+
+
+/**
+ * @brief Start positions of regular expression matches
+ *
+ * Tree is walked together with DFA: each path of tree is read by automaton once, so common prefixes
+ * of suffixes are processed once. Path is cut in dead state, when state is accepting all leafs below
+ * path are reported and path is cut too, so each position is reported once. Each node of tree is
+ * reached by one path, so pairs of node and state never repeat and don't need memoisation. Before
+ * walk required literal of expression is checked by exact descent.
+ *
+ * Automaton keeps states built by previous queries, so caller which repeats queries of one expression
+ * (e.g. one automaton per thread) doesn't build DFA and doesn't allocate memory in steady state.
+ *
+ * @param tree suffix tree
+ * @param automaton DFA of compiled expression
+ * @param sink called as `sink(int32_t position)` in arbitrary order, returns false to stop query
+ * @param max_steps max count of letters read by automaton, bounds latency of query
+ * @returns false if query was stopped by sink or by count of steps
+ */
+template <typename Alphabet, typename Sink>
+bool find_regex(const SuffixTree<Alphabet>& tree, typename Regex<Alphabet>::Automaton& automaton, Sink&& sink,
+                int64_t max_steps = std::numeric_limits<int64_t>::max());
+
+// Same as above, but DFA is built for this query only.
+template <typename Alphabet, typename Sink>
+bool find_regex(const SuffixTree<Alphabet>& tree, const Regex<Alphabet>& regex, Sink&& sink,
+                int64_t max_steps = std::numeric_limits<int64_t>::max());
+
+// Same as above, but positions are returned in ascending order.
+template <typename Alphabet>
+std::vector<int32_t> find_regex(const SuffixTree<Alphabet>& tree, std::string_view pattern,
+                                int64_t max_steps = std::numeric_limits<int64_t>::max());
+
+
+template <typename Alphabet>
+Regex<Alphabet>::Regex(std::string_view pattern)
+{
+    size_t idx = 0;
+    Fragment fragment = parse_alternation(pattern, idx);
+    assert(idx == pattern.size() && "unbalanced parenthesis");
+
+    nfa_start = fragment.start;
+    nfa_accept = fragment.end;
+    required = fragment.required;
+}
+
+
+template <typename Alphabet>
+int32_t Regex<Alphabet>::add_state()
+{
+    nfa.emplace_back();
+    return nfa.size() - 1;
+}
+
+
+template <typename Alphabet>
+typename Regex<Alphabet>::Fragment Regex<Alphabet>::empty_fragment()
+{
+    int32_t state = add_state();
+    return {state, state, true, "", "", "", ""};
+}
+
+
+template <typename Alphabet>
+typename Regex<Alphabet>::Fragment Regex<Alphabet>::letters_fragment(const LetterSet& letters)
+{
+    int32_t start = add_state(), end = add_state();
+    nfa[start].letters = letters;
+    nfa[start].next = end;
+
+    // one letter is literal
+    if(letters.count() != 1)
+    {
+        return {start, end, false, "", "", "", ""};
+    }
+
+    std::string letter;
+    for(int32_t ch = 0; ch < Alphabet::max_alphabet_size && letter.empty(); ++ch)
+        if(alphabet.index_of(ch) >= 0 && letters.test(alphabet.index_of(ch)))
+            letter += static_cast<char>(ch);
+
+    return {start, end, true, letter, letter, letter, letter};
+}
+
+
+template <typename Alphabet>
+typename Regex<Alphabet>::Fragment Regex<Alphabet>::parse_alternation(std::string_view pattern, size_t& idx)
+{
+    Fragment fragment = parse_concatenation(pattern, idx);
+    while(idx < pattern.size() && pattern[idx] == '|')
+    {
+        Fragment other = parse_concatenation(pattern, ++idx);
+
+        int32_t start = add_state(), end = add_state();
+        nfa[start].epsilons = {fragment.start, other.start};
+        nfa[fragment.end].epsilons.push_back(end);
+        nfa[other.end].epsilons.push_back(end);
+
+        bool same = fragment.is_exact && other.is_exact && fragment.exact == other.exact;
+        fragment = {start, end, same, same ? other.exact : "", "", "", same ? other.exact : ""};
+    }
+
+    return fragment;
+}
+
+
+template <typename Alphabet>
+typename Regex<Alphabet>::Fragment Regex<Alphabet>::parse_concatenation(std::string_view pattern, size_t& idx)
+{
+    Fragment fragment = empty_fragment();
+    while(idx < pattern.size() && pattern[idx] != '|' && pattern[idx] != ')')
+    {
+        Fragment other = parse_repetition(pattern, idx);
+        nfa[fragment.end].epsilons.push_back(other.start);
+
+        // literal could cross border of fragments
+        std::string crossing = fragment.suffix + other.prefix;
+        std::string required = std::max({fragment.required, other.required, crossing}, [](const auto& lhs, const auto& rhs)
+        {
+            return lhs.size() < rhs.size();
+        });
+
+        std::string prefix = fragment.is_exact ? fragment.exact + other.prefix : fragment.prefix;
+        std::string suffix = other.is_exact ? fragment.suffix + other.exact : other.suffix;
+
+        bool is_exact = fragment.is_exact && other.is_exact;
+        fragment = {fragment.start, other.end, is_exact, is_exact ? fragment.exact + other.exact : "", prefix, suffix, required};
+    }
+
+    return fragment;
+}
+
+
+template <typename Alphabet>
+typename Regex<Alphabet>::Fragment Regex<Alphabet>::parse_repetition(std::string_view pattern, size_t& idx)
+{
+    Fragment fragment = parse_atom(pattern, idx);
+    for(; idx < pattern.size() && (pattern[idx] == '*' || pattern[idx] == '+' || pattern[idx] == '?'); ++idx)
+    {
+        if(pattern[idx] == '+')
+        {
+            // at least one repetition keeps literals, but string isn't exact
+            int32_t end = add_state();
+            nfa[fragment.end].epsilons.push_back(fragment.start);
+            nfa[fragment.end].epsilons.push_back(end);
+            fragment = {fragment.start, end, false, "", fragment.prefix, fragment.suffix, fragment.required};
+            continue;
+        }
+
+        int32_t start = add_state(), end = add_state();
+        nfa[start].epsilons = {fragment.start, end};
+        nfa[fragment.end].epsilons.push_back(end);
+        if(pattern[idx] == '*')
+            nfa[fragment.end].epsilons.push_back(fragment.start);
+
+        fragment = {start, end, false, "", "", "", ""};
+    }
+
+    return fragment;
+}
+
+
+template <typename Alphabet>
+typename Regex<Alphabet>::Fragment Regex<Alphabet>::parse_atom(std::string_view pattern, size_t& idx)
+{
+    assert(idx < pattern.size());
+
+    if(pattern[idx] == '(')
+    {
+        Fragment fragment = parse_alternation(pattern, ++idx);
+        assert(idx < pattern.size() && pattern[idx] == ')' && "unbalanced parenthesis");
+        ++idx;
+        return fragment;
+    }
+
+    // letters and classes have same syntax as in wildcard patterns
+    size_t end = idx + 1;
+    if(pattern[idx] == '[')
+    {
+        end = WildcardPattern<Alphabet>::class_end(pattern, idx) + 1;
+        assert(end <= pattern.size() && "class of letters is not closed");
+    }
+    else if(pattern[idx] == '\\')
+    {
+        end = std::min(idx + 2, pattern.size());
+    }
+    else
+    {
+        assert(pattern[idx] != '*' && pattern[idx] != '+' && pattern[idx] != '?' && "repetition of nothing");
+    }
+
+    std::string_view atom = pattern.substr(idx, end - idx);
+    idx = end;
+    return letters_fragment(WildcardPattern<Alphabet>(atom == "." ? "?" : atom).letters_of(0));
+}
+
+
+template <typename Alphabet>
+Regex<Alphabet>::Automaton::Automaton(const Regex& regex) : regex(regex)
+{
+    start_state = state_of({regex.nfa_start});
+}
+
+
+template <typename Alphabet>
+int32_t Regex<Alphabet>::Automaton::state_of(std::vector<int32_t> nfa_states)
+{
+    const std::vector<NfaState>& nfa = regex.nfa;
+
+    // epsilon closure
+    std::vector<bool> visited(nfa.size());
+    for(int32_t state : nfa_states)
+        visited[state] = true;
+
+    for(size_t idx = 0; idx < nfa_states.size(); ++idx)
+        for(int32_t next : nfa[nfa_states[idx]].epsilons)
+            if(!visited[next])
+            {
+                visited[next] = true;
+                nfa_states.push_back(next);
+            }
+
+    // only states with letter transitions and accepting state matter
+    nfa_states.erase(std::remove_if(nfa_states.begin(), nfa_states.end(), [&](int32_t state)
+    {
+        return nfa[state].next == -1 && state != regex.nfa_accept;
+    }), nfa_states.end());
+
+    if(nfa_states.empty())
+    {
+        return dead_state;
+    }
+
+    std::sort(nfa_states.begin(), nfa_states.end());
+    auto [it, inserted] = states.emplace(nfa_states, sets.size());
+    if(inserted)
+    {
+        accepting.push_back(std::binary_search(nfa_states.begin(), nfa_states.end(), regex.nfa_accept));
+        transitions.resize(transitions.size() + Alphabet::size(), -2);
+        sets.push_back(std::move(nfa_states));
+    }
+
+    return it->second;
+}
+
+
+template <typename Alphabet>
+int32_t Regex<Alphabet>::Automaton::next(int32_t state, char ch)
+{
+    int32_t ch_idx = alphabet.index_of(ch);
+    if(state == dead_state || ch_idx < 0)
+    {
+        return dead_state;
+    }
+
+    int32_t& transition = transitions[state * Alphabet::size() + ch_idx];
+    if(transition == -2)
+    {
+        const std::vector<NfaState>& nfa = regex.nfa;
+
+        std::vector<int32_t> targets;
+        for(int32_t nfa_state : sets[state])
+            if(nfa[nfa_state].next != -1 && nfa[nfa_state].letters.test(ch_idx))
+                targets.push_back(nfa[nfa_state].next);
+
+        // new state could reallocate transitions
+        int32_t target = state_of(std::move(targets));
+        transitions[state * Alphabet::size() + ch_idx] = target;
+        return target;
+    }
+
+    return transition;
+}
+
+
+template <typename Alphabet, typename Sink>
+bool find_regex(const SuffixTree<Alphabet>& tree, typename Regex<Alphabet>::Automaton& automaton, Sink&& sink, int64_t max_steps)
+{
+    using node_reference = typename SuffixTree<Alphabet>::node_reference;
+
+    // expression can't match without its required literal
+    if(!tree.contains(automaton.expression().required_literal()))
+    {
+        return true;
+    }
+
+    // suffix of terminal doesn't start at position of source
+    int32_t text_size = tree.suffixes_count() - 1;
+    auto report = [&](node_reference node)
+    {
+        if(tree.is_leaf(node))
+        {
+            return tree.suffix_of(node) == text_size || static_cast<bool>(sink(tree.suffix_of(node)));
+        }
+
+        auto [leaf_begin, leaf_end] = tree.leaf_range(node);
+        for(int32_t leaf_number = leaf_begin; leaf_number < leaf_end; ++leaf_number)
+            if(tree.suffix_at(leaf_number) != text_size && !sink(tree.suffix_at(leaf_number)))
+                return false;
+
+        return true;
+    };
+
+    // empty string matches at each position
+    if(automaton.is_accepting(automaton.start()))
+    {
+        return report(tree.root());
+    }
+
+    // each stack item is node and state of automaton after string of node
+    ScratchVector<std::pair<node_reference, int32_t>> stack_scratch;
+    std::vector<std::pair<node_reference, int32_t>>& stack = stack_scratch.get();
+    stack.assign(1, {tree.root(), automaton.start()});
+
+    bool stopped = false;
+    while(!stack.empty() && !stopped)
+    {
+        auto [node, node_state] = stack.back();
+        stack.pop_back();
+
+        tree.for_each_child(node, [&](node_reference child, std::string_view label)
+        {
+            int32_t state = node_state;
+            for(size_t idx = 0; idx < label.size() && !stopped; ++idx)
+            {
+                stopped = --max_steps < 0;
+                state = automaton.next(state, label[idx]);
+
+                if(state == Regex<Alphabet>::dead_state)
+                    return;
+
+                if(automaton.is_accepting(state))
+                {
+                    stopped = stopped || !report(child);
+                    return;
+                }
+            }
+
+            if(!stopped)
+                stack.emplace_back(child, state);
+        });
+    }
+
+    return !stopped;
+}
+
+
+template <typename Alphabet, typename Sink>
+bool find_regex(const SuffixTree<Alphabet>& tree, const Regex<Alphabet>& regex, Sink&& sink, int64_t max_steps)
+{
+    typename Regex<Alphabet>::Automaton automaton(regex);
+    return find_regex(tree, automaton, sink, max_steps);
+}
+
+
+template <typename Alphabet>
+std::vector<int32_t> find_regex(const SuffixTree<Alphabet>& tree, std::string_view pattern, int64_t max_steps)
+{
+    std::vector<int32_t> positions;
+    find_regex(tree, Regex<Alphabet>(pattern), [&](int32_t position)
+    {
+        positions.push_back(position);
+        return true;
+    }, max_steps);
+
+    std::sort(positions.begin(), positions.end());
+    return positions;
+}
+
+} // custom
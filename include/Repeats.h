@@ -0,0 +1,166 @@
+#pragma once
+
+#include "SuffixTree.h"
+
+#include <bitset>
+
+namespace custom
+{
+
+/**
+ * @brief Repeated substring of source
+ *
+ * Substring is `text.substr(position, length)`, position is one of its occurrences.
+ */
+struct Repeat
+{
+    int32_t position;
+    int32_t length;
+    int32_t count;
+};
+
+
+/**
+ * @brief Enumeration of maximal repeats
+ *
+ * Repeat is maximal if it can't be extended to the right (it ends in inner node) and to the left
+ * (its occurrences are preceded by different letters or one of them starts source). Left diversity
+ * is annotated in one post-order pass. Subtrees with less than `min_count` leafs are not visited,
+ * letters before their leafs are checked directly.
+ *
+ * @param tree suffix tree
+ * @param min_length repeats shorter than this value are not reported
+ * @param min_count repeats with less occurrences are not reported
+ * @param sink called as `sink(const Repeat&)` in post-order, returns false to stop enumeration
+ * @returns false if enumeration was stopped by sink
+ */
+template <typename Alphabet, typename Sink>
+bool find_maximal_repeats(const SuffixTree<Alphabet>& tree, int32_t min_length, int32_t min_count, Sink&& sink);
+
+/**
+ * @brief Enumeration of supermaximal repeats
+ *
+ * Repeat is supermaximal if it isn't substring of other repeat: all childs of its node are leafs
+ * and letters before these leafs are distinct. Parameters are same as for `find_maximal_repeats`.
+ */
+template <typename Alphabet, typename Sink>
+bool find_supermaximal_repeats(const SuffixTree<Alphabet>& tree, int32_t min_length, int32_t min_count, Sink&& sink);
+
+
+namespace details
+{
+
+/**
+ * @brief Letters before leafs of subtree
+ *
+ * Leaf which starts source has no letter before it, it differs from any letter.
+ */
+struct LeftLetters
+{
+    static constexpr int32_t none = -1;
+    static constexpr int32_t start = 256;
+    static constexpr int32_t diverse = 257;
+
+    int32_t letter = none;
+
+    // letters of childs which are leafs, to check are they distinct
+    std::bitset<start + 1> leaf_letters;
+    bool only_leafs = true;
+    bool distinct_leafs = true;
+
+    void merge(int32_t other)
+    {
+        letter = letter == none || letter == other ? other : diverse;
+    }
+};
+
+
+template <typename Alphabet, typename Sink>
+bool find_repeats(const SuffixTree<Alphabet>& tree, int32_t min_length, int32_t min_count, bool supermaximal, Sink& sink)
+{
+    using node_reference = typename SuffixTree<Alphabet>::node_reference;
+
+    std::string_view text = tree.text();
+    auto letter_before = [&](int32_t position)
+    {
+        return position == 0 ? LeftLetters::start : static_cast<unsigned char>(text[position - 1]);
+    };
+
+    std::vector<LeftLetters> frames;
+    bool stopped = false;
+
+    tree.traverse(tree.root(), [&](node_reference node, std::string_view)
+    {
+        if(stopped || tree.is_leaf(node))
+            return false;
+
+        frames.emplace_back();
+
+        auto [leaf_begin, leaf_end] = tree.leaf_range(node);
+        if(leaf_end - leaf_begin >= min_count)
+            return true;
+
+        // small subtree has no repeats to report, only letters before its leafs matter for parent
+        for(int32_t leaf_number = leaf_begin; leaf_number < leaf_end && frames.back().letter != LeftLetters::diverse; ++leaf_number)
+            frames.back().merge(letter_before(tree.suffix_at(leaf_number)));
+
+        frames.back().only_leafs = false;
+        return false;
+    },
+    [&](node_reference node)
+    {
+        if(stopped)
+            return;
+
+        if(tree.is_leaf(node))
+        {
+            LeftLetters& parent = frames.back();
+            int32_t letter = letter_before(tree.suffix_of(node));
+
+            parent.merge(letter);
+            parent.distinct_leafs = parent.distinct_leafs && !parent.leaf_letters[letter];
+            parent.leaf_letters[letter] = true;
+            return;
+        }
+
+        LeftLetters frame = frames.back();
+        frames.pop_back();
+
+        if(!frames.empty())
+        {
+            frames.back().merge(frame.letter);
+            frames.back().only_leafs = false;
+        }
+
+        auto [leaf_begin, leaf_end] = tree.leaf_range(node);
+        int32_t length = tree.string_depth(node);
+        int32_t count = leaf_end - leaf_begin;
+
+        bool maximal = node != tree.root() && frame.letter == LeftLetters::diverse;
+        if(supermaximal)
+            maximal = maximal && frame.only_leafs && frame.distinct_leafs;
+
+        if(maximal && length >= min_length && count >= min_count)
+            stopped = !sink(Repeat{tree.suffix_at(leaf_begin), length, count});
+    });
+
+    return !stopped;
+}
+
+} // namespace details
+
+
+template <typename Alphabet, typename Sink>
+bool find_maximal_repeats(const SuffixTree<Alphabet>& tree, int32_t min_length, int32_t min_count, Sink&& sink)
+{
+    return details::find_repeats(tree, min_length, std::max(min_count, 2), false, sink);
+}
+
+
+template <typename Alphabet, typename Sink>
+bool find_supermaximal_repeats(const SuffixTree<Alphabet>& tree, int32_t min_length, int32_t min_count, Sink&& sink)
+{
+    return details::find_repeats(tree, min_length, std::max(min_count, 2), true, sink);
+}
+
+} // custom
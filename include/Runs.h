@@ -0,0 +1,192 @@
+#pragma once
+
+#include "LongestCommonExtension.h"
+
+namespace custom
+{
+
+/**
+ * @brief Maximal repetition (run) of source
+ *
+ * Substring `text.substr(start, length)` has the smallest period `period`, it is at least twice longer
+ * than period and can't be extended with the same period. Each tandem repeat (square) of source is
+ * substring of some run.
+ */
+struct Run
+{
+    int32_t start;
+    int32_t period;
+    int32_t length;
+};
+
+
+/**
+ * @brief Runs of source
+ *
+ * Run with period p covers at least two consecutive positions of form k * p, so for each period only
+ * these positions are checked: common extension to the right of positions q and q + p and common
+ * extension to the left give repetition around q, it is reported from the first such position only.
+ * Extension to the left is found by extensions to the right too: one of them checks is it long enough
+ * for repetition and binary search finds its length only for positions which start repetitions, so
+ * there is no index of reversed source. Repetition is a run if no divisor of p is its period. Each
+ * period costs O(n / p) constant time extensions and starts of repetitions cost O(log n) each, so
+ * time complexity is O(n log n). Memory is one `LongestCommonExtension` index of tree.
+ *
+ * @param tree suffix tree
+ * @param sink called as `sink(const Run&)` in ascending order of periods, returns false to stop enumeration
+ * @param threads_count max count of threads for preprocessing
+ * @returns false if enumeration was stopped by sink
+ */
+template <typename Alphabet, typename Sink>
+bool find_runs(const SuffixTree<Alphabet>& tree, Sink&& sink, size_t threads_count = default_threads_count());
+
+// Same as above, but periods are processed in parallel and runs are returned in ascending order of start positions.
+template <typename Alphabet>
+std::vector<Run> find_runs_parallel(const SuffixTree<Alphabet>& tree, size_t threads_count = default_threads_count());
+
+
+namespace details
+{
+
+// repetitions by common extensions
+template <typename Alphabet>
+class RunsContext
+{
+public:
+    RunsContext(const SuffixTree<Alphabet>& tree, size_t threads_count);
+
+    // Runs of period are passed to callback, returns false if stopped by callback.
+    template <typename Callback>
+    bool runs_of_period(int32_t period, Callback&& callback) const;
+
+    int32_t size() const { return text_size; }
+
+private:
+    // checks has substring smaller period than given one
+    bool has_smaller_period(int32_t start, int32_t period, int32_t length) const;
+
+    // checks are `length` letters before 'position' and before 'position + period' equal
+    bool extends_left(int32_t position, int32_t period, int32_t length) const;
+
+private:
+    int32_t text_size;
+    LongestCommonExtension<Alphabet> forward;
+};
+
+
+template <typename Alphabet>
+RunsContext<Alphabet>::RunsContext(const SuffixTree<Alphabet>& tree, size_t threads_count)
+    : text_size(tree.suffixes_count() - 1), forward(tree, threads_count)
+{
+}
+
+
+template <typename Alphabet>
+bool RunsContext<Alphabet>::extends_left(int32_t position, int32_t period, int32_t length) const
+{
+    return length == 0 || (length <= position && forward.longest_common_extension(position - length, position - length + period) >= length);
+}
+
+
+template <typename Alphabet>
+bool RunsContext<Alphabet>::has_smaller_period(int32_t start, int32_t period, int32_t length) const
+{
+    // repetition is at least twice longer than period, so its smallest period divides period
+    for(int32_t rest = period, divisor = 2; rest > 1; ++divisor)
+    {
+        if(divisor * divisor > rest)
+            divisor = rest;
+
+        if(rest % divisor != 0)
+            continue;
+
+        int32_t smaller = period / divisor;
+        if(forward.longest_common_extension(start, start + smaller) >= length - smaller)
+            return true;
+
+        while(rest % divisor == 0)
+            rest /= divisor;
+    }
+
+    return false;
+}
+
+
+template <typename Alphabet>
+template <typename Callback>
+bool RunsContext<Alphabet>::runs_of_period(int32_t period, Callback&& callback) const
+{
+    for(int32_t position = 0; position + period < text_size; position += period)
+    {
+        int32_t right = forward.longest_common_extension(position, position + period);
+
+        // repetition is found from the first position inside it and it is at least twice longer than period
+        int32_t needed = std::max(0, period - right);
+        if(extends_left(position, period, period) || !extends_left(position, period, needed))
+            continue;
+
+        // the longest extension to the left is shorter than period
+        int32_t left = needed, limit = std::min(position, period - 1);
+        while(left < limit)
+        {
+            int32_t middle = left + (limit - left + 1) / 2;
+            if(extends_left(position, period, middle))
+                left = middle;
+            else
+                limit = middle - 1;
+        }
+
+        int32_t length = left + period + right;
+        int32_t start = position - left;
+        if(!has_smaller_period(start, period, length) && !callback(Run{start, period, length}))
+            return false;
+    }
+
+    return true;
+}
+
+} // namespace details
+
+
+template <typename Alphabet, typename Sink>
+bool find_runs(const SuffixTree<Alphabet>& tree, Sink&& sink, size_t threads_count)
+{
+    details::RunsContext<Alphabet> context(tree, threads_count);
+
+    for(int32_t period = 1; 2 * period <= context.size(); ++period)
+        if(!context.runs_of_period(period, sink))
+            return false;
+
+    return true;
+}
+
+
+template <typename Alphabet>
+std::vector<Run> find_runs_parallel(const SuffixTree<Alphabet>& tree, size_t threads_count)
+{
+    threads_count = std::max<size_t>(1, threads_count);
+    details::RunsContext<Alphabet> context(tree, threads_count);
+
+    std::vector<std::vector<Run>> thread_runs(threads_count);
+    parallel_for(context.size() / 2, threads_count, [&](size_t period_idx, size_t thread_idx)
+    {
+        context.runs_of_period(period_idx + 1, [&](const Run& run)
+        {
+            thread_runs[thread_idx].push_back(run);
+            return true;
+        });
+    });
+
+    std::vector<Run> runs;
+    for(std::vector<Run>& part : thread_runs)
+        runs.insert(runs.end(), part.begin(), part.end());
+
+    std::sort(runs.begin(), runs.end(), [](const Run& lhs, const Run& rhs)
+    {
+        return lhs.start != rhs.start ? lhs.start < rhs.start : lhs.period < rhs.period;
+    });
+
+    return runs;
+}
+
+} // custom
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <cstddef>
+
+namespace custom
+{
+
+/**
+ * @brief Per-thread memory reused by queries
+ *
+ * Each thread keeps a pool of vectors for each type of elements. Lease takes the next free vector
+ * of pool and returns it on destruction, so queries don't allocate memory in steady state. Query
+ * started from sink of other query on the same thread takes another vector instead of clearing the
+ * one which is in use, so nested queries are safe and they don't allocate in steady state either.
+ */
+template <typename T>
+class ScratchVector
+{
+public:
+    ScratchVector() : buffer(acquire()) {}
+    ~ScratchVector() { --depth(); }
+
+    ScratchVector(const ScratchVector&) = delete;
+    ScratchVector& operator=(const ScratchVector&) = delete;
+
+    // Empty vector which belongs to lease until its destruction.
+    std::vector<T>& get() { return buffer; }
+
+private:
+    static std::vector<T>& acquire()
+    {
+        // deque doesn't move its elements on growth, so leased vectors stay valid
+        static thread_local std::deque<std::vector<T>> pool;
+        if(depth() == pool.size())
+            pool.emplace_back();
+
+        std::vector<T>& vector = pool[depth()++];
+        vector.clear();
+        return vector;
+    }
+
+    // count of leased vectors of pool
+    static size_t& depth()
+    {
+        static thread_local size_t leased = 0;
+        return leased;
+    }
+
+private:
+    std::vector<T>& buffer;
+};
+
+} // namespace custom
@@ -0,0 +1,182 @@
+#pragma once
+
+#include "SuffixTree.h"
+
+#include <array>
+
+namespace custom
+{
+
+/**
+ * @brief Suffix array of source
+ *
+ * Suffixes include terminal, so array has `suffixes_count()` values and starts with suffix which
+ * consists of terminal only. Values are passed to `sink(size_t first, const int32_t* values, size_t count)`
+ * in chunks, where `first` is index of `values[0]` in array, so arrays of any size could be written
+ * to file or caller's buffer without full-size temporaries.
+ *
+ * @returns false if export was stopped by sink
+ */
+template <typename Alphabet, typename Sink>
+bool export_suffix_array(const SuffixTree<Alphabet>& tree, Sink&& sink);
+
+/**
+ * @brief LCP array of source
+ *
+ * Value `k` is length of common prefix of suffixes `k - 1` and `k` of suffix array, the first value
+ * is zero. Leafs are visited in lexicographic order and common prefix of neighbours is string depth
+ * of the highest parent met between them, so time is O(n). Sink is same as for `export_suffix_array`.
+ *
+ * @returns false if export was stopped by sink
+ */
+template <typename Alphabet, typename Sink>
+bool export_lcp_array(const SuffixTree<Alphabet>& tree, Sink&& sink);
+
+/**
+ * @brief Burrows-Wheeler transform of source
+ *
+ * Letter `k` precedes suffix `k` of suffix array, suffix which starts source is preceded by terminal.
+ * Letters are passed to `sink(size_t first, const char* letters, size_t count)` in chunks.
+ *
+ * @returns false if export was stopped by sink
+ */
+template <typename Alphabet, typename Sink>
+bool export_bwt(const SuffixTree<Alphabet>& tree, Sink&& sink);
+
+/**
+ * @brief Inverse suffix array of source
+ *
+ * Value `i` is index of suffix `i` in suffix array. Writes are scattered over whole array, so it can't
+ * be streamed in order and is written into caller's buffer (e.g. mapped file) instead, chunks of
+ * suffix array are processed in parallel.
+ *
+ * @param tree suffix tree
+ * @param isa caller-provided array of size `suffixes_count()`
+ * @param threads_count max count of threads
+ */
+template <typename Alphabet>
+void export_inverse_suffix_array(const SuffixTree<Alphabet>& tree, int32_t* isa, size_t threads_count = default_threads_count());
+
+
+namespace details
+{
+
+// values of exported array are passed to sink by chunks, chunk is kept on stack of export
+template <typename T, typename Sink>
+class ChunkStream
+{
+public:
+    static constexpr size_t chunk_size = 4096;
+
+public:
+    explicit ChunkStream(Sink& sink) : sink(sink) {}
+
+    // returns false if stopped by sink
+    bool push(T value)
+    {
+        chunk[size++] = value;
+        return size < chunk_size || flush();
+    }
+
+    // passes rest of values to sink
+    bool flush()
+    {
+        if(size == 0)
+        {
+            return true;
+        }
+
+        bool proceed = sink(written, chunk.data(), size);
+        written += size;
+        size = 0;
+        return proceed;
+    }
+
+private:
+    Sink& sink;
+    size_t written = 0;
+
+    std::array<T, chunk_size> chunk;
+    size_t size = 0;
+};
+
+} // namespace details
+
+
+template <typename Alphabet, typename Sink>
+bool export_suffix_array(const SuffixTree<Alphabet>& tree, Sink&& sink)
+{
+    details::ChunkStream<int32_t, Sink> stream(sink);
+    for(int32_t leaf_number = 0; leaf_number < tree.suffixes_count(); ++leaf_number)
+        if(!stream.push(tree.suffix_at(leaf_number)))
+            return false;
+
+    return stream.flush();
+}
+
+
+template <typename Alphabet, typename Sink>
+bool export_lcp_array(const SuffixTree<Alphabet>& tree, Sink&& sink)
+{
+    using node_reference = typename SuffixTree<Alphabet>::node_reference;
+
+    details::ChunkStream<int32_t, Sink> stream(sink);
+    bool stopped = false;
+
+    // the first node entered after leaf is child of lowest common ancestor of leaf and next one
+    int32_t common = 0;
+    tree.traverse(tree.root(), [&](node_reference node, std::string_view label)
+    {
+        if(stopped)
+            return false;
+
+        if(node != tree.root())
+            common = std::min<int32_t>(common, tree.string_depth(node) - label.size());
+
+        if(tree.is_leaf(node))
+        {
+            stopped = !stream.push(common);
+            common = std::numeric_limits<int32_t>::max();
+        }
+
+        return true;
+    },
+    [](node_reference) {});
+
+    return !stopped && stream.flush();
+}
+
+
+template <typename Alphabet, typename Sink>
+bool export_bwt(const SuffixTree<Alphabet>& tree, Sink&& sink)
+{
+    std::string_view text = tree.text();
+
+    details::ChunkStream<char, Sink> stream(sink);
+    for(int32_t leaf_number = 0; leaf_number < tree.suffixes_count(); ++leaf_number)
+    {
+        int32_t position = tree.suffix_at(leaf_number);
+        if(!stream.push(position == 0 ? text.back() : text[position - 1]))
+            return false;
+    }
+
+    return stream.flush();
+}
+
+
+template <typename Alphabet>
+void export_inverse_suffix_array(const SuffixTree<Alphabet>& tree, int32_t* isa, size_t threads_count)
+{
+    // chunks smaller than this are not worth of thread synchronisation
+    static constexpr int32_t chunk_size = 1 << 16;
+
+    int32_t suffixes_count = tree.suffixes_count();
+    parallel_for((suffixes_count + chunk_size - 1) / chunk_size, threads_count, [&](size_t chunk_idx, size_t)
+    {
+        int32_t chunk_end = std::min<int64_t>(suffixes_count, (chunk_idx + 1) * chunk_size);
+        for(int32_t leaf_number = chunk_idx * chunk_size; leaf_number < chunk_end; ++leaf_number)
+            isa[tree.suffix_at(leaf_number)] = leaf_number;
+    });
+}
+
+} // custom
@@ -1,12 +1,19 @@
 #pragma once
 
 #include "Alphabet.h"
+#include "OutputBuffer.h"
+#include "Parallel.h"
+#include "Scratch.h"
 
 #include <string>
 #include <string_view>
 #include <cstring>
 #include <vector>
 #include <array>
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <type_traits>
 
 namespace custom
 {
@@ -77,6 +84,17 @@ private:
 
         reference_to_node suffix_connection;
         std::array<reference_to_edge, Alphabet::size()> edges_to_childs;
+
+        // filled after construction by 'annotate_tree'
+        reference_to_node parent = -1;
+        reference_to_edge incoming_edge = no_connection;
+
+        // leafs of subtree numbered in lexicographic order: [leaf_begin, leaf_end)
+        int32_t leaf_begin = 0;
+        int32_t leaf_end = 0;
+
+        // length of string from root to node
+        int32_t string_depth = 0;
     };
 
 private:
@@ -98,6 +116,30 @@ private:
         reference_to_node next_node_addr;
     };
 
+public:
+    class Cursor;
+
+    // Substring which continues some prefix and count of its occurrences.
+    struct Completion
+    {
+        std::string_view text;
+        int32_t count;
+    };
+
+    // Strategy to choose subset of occurrences.
+    enum class SampleMode
+    {
+        leftmost,
+        random
+    };
+
+    // Longest prefix of query's suffix which occurs in source: `text().substr(position, length)`.
+    struct Match
+    {
+        int32_t length;
+        int32_t position;
+    };
+
 public:
     SuffixTree(std::string_view source);
 
@@ -117,10 +159,180 @@ public:
      */
     bool contains(std::string_view pattern) const { return index_of(pattern) != -1; }
 
+    /**
+     * @brief Most frequent continuations of prefix
+     * 
+     * Continuations are substrings which start with prefix and end on edge boundaries of tree 
+     * (longest substrings with same set of occurrences). Tree is walked best-first from prefix's 
+     * locus, so time complexity is O(m + k log k) up to size of alphabet.
+     * 
+     * @param prefix beginning of all continuations
+     * @param k max count of continuations
+     * @param min_length continuations shorter than this value are not reported
+     * @param max_length longer continuations are truncated to this value
+     * @returns continuations ordered by count of occurrences, views refer to tree's memory
+     */
+    std::vector<Completion> top_completions(std::string_view prefix, size_t k, int32_t min_length = 0,
+                                            int32_t max_length = std::numeric_limits<int32_t>::max()) const;
+
+    /**
+     * @brief Most frequent continuations of prefix reported to sink
+     * 
+     * Same as above, but continuations are passed to `sink(const Completion&)` which returns false to 
+     * stop query. Doesn't allocate memory in steady state.
+     * 
+     * @returns false if query was stopped by sink
+     */
+    template <typename Sink>
+    bool top_completions(std::string_view prefix, size_t k, int32_t min_length, int32_t max_length, Sink&& sink) const;
+
+    /**
+     * @brief All occurrences of pattern
+     * 
+     * @param pattern string to match as substring, empty pattern occurs at each position of source
+     * @returns positions of all occurrences in lexicographic order of suffixes
+     */
+    std::vector<int32_t> find_all(std::string_view pattern) const;
+
+    /**
+     * @brief All occurrences of pattern reported to sink
+     * 
+     * Positions are passed to `sink(int32_t)` which returns false to stop query. Doesn't allocate memory.
+     * 
+     * @returns false if query was stopped by sink
+     */
+    template <typename Sink>
+    bool find_all(std::string_view pattern, Sink&& sink) const;
+
+    /**
+     * @brief All occurrences of pattern found by several threads
+     * 
+     * Occurrences are contiguous range of lexicographic leaf numbers, so range is split to chunks 
+     * which threads take one by one. Each chunk is written to own place of result, sorting is done 
+     * per chunk and followed by parallel pairwise merge of chunks.
+     * 
+     * @param pattern string to match as substring
+     * @param threads_count max count of threads
+     * @param sorted if true positions are returned in ascending order, otherwise in lexicographic order of suffixes
+     * @returns positions of all occurrences
+     */
+    std::vector<int32_t> find_all_parallel(std::string_view pattern, size_t threads_count = default_threads_count(), 
+                                           bool sorted = false) const;
+
+    /**
+     * @brief Some occurrences of pattern
+     * 
+     * Subtree of pattern's locus is not enumerated: leftmost occurrences are taken best-first by 
+     * first position of each edge and random occurrences are taken by leaf numbers of locus. So 
+     * time complexity doesn't depend on total count of occurrences.
+     * 
+     * @param pattern string to match as substring
+     * @param k max count of positions
+     * @param mode `leftmost` returns k first positions in ascending order and `random` returns 
+     *  k positions chosen uniformly without repetitions
+     * @param seed seed of random generator for `random` mode
+     * @returns positions of occurrences
+     */
+    std::vector<int32_t> sample_occurrences(std::string_view pattern, size_t k, SampleMode mode = SampleMode::leftmost, 
+                                            uint32_t seed = std::mt19937::default_seed) const;
+
+    /**
+     * @brief Some occurrences of pattern reported to sink
+     * 
+     * Same as above, but positions are passed to `sink(int32_t)` which returns false to stop query. 
+     * Doesn't allocate memory in steady state.
+     * 
+     * @returns false if query was stopped by sink
+     */
+    template <typename Sink>
+    bool sample_occurrences(std::string_view pattern, size_t k, SampleMode mode, uint32_t seed, Sink&& sink) const;
+
+    /**
+     * @brief Matching statistics of query against source
+     * 
+     * For each position of query finds the longest prefix of its suffix which occurs in source. Query 
+     * is streamed through tree: when match can't be extended, its first letter is dropped by suffix 
+     * connection instead of search from the root, so time complexity is O(m) in total.
+     * 
+     * @param query text to compare with source
+     * @returns match for each position of query, position of match is its first occurrence in source
+     */
+    std::vector<Match> matching_statistics(std::string_view query) const;
+
+    /**
+     * @brief Matching statistics reported to sink in chunks
+     * 
+     * Same as above, but matches are passed to `sink(size_t first, const Match* matches, size_t count)` 
+     * where `first` is position of `matches[0]` in query, sink returns false to stop query. Doesn't 
+     * allocate memory in steady state.
+     * 
+     * @returns false if query was stopped by sink
+     */
+    template <typename Sink>
+    bool matching_statistics(std::string_view query, Sink&& sink) const;
+
+    // Count of suffixes (leafs of tree) including suffix which consists of terminal only.
+    int32_t suffixes_count() const { return suffix_array.size(); }
+
+    // Start position of suffix by its lexicographic leaf number.
+    int32_t suffix_at(int32_t leaf_number) const { return suffix_array[leaf_number]; }
+
+public:
+    /**
+     * @brief Read-only structure of tree
+     * 
+     * Algorithms built on top of tree address nodes by references: non-negative values are inner 
+     * nodes and negative values are leafs. Childs are always visited in lexicographic order (order 
+     * of letters in alphabet), so leafs are met in order of their lexicographic numbers.
+     */
+    using node_reference = reference_to_node;
+
+    // Source expanded with terminal symbol.
+    std::string_view text() const { return expanded_string; }
+
+    node_reference root() const { return root_addr; }
+
+    // References of all inner nodes are in range [0, nodes_count()).
+    int32_t nodes_count() const { return node_allocator.size(); }
+
+    bool is_leaf(node_reference ref) const { return ref < 0; }
+
+    // Start position of suffix which ends in leaf.
+    int32_t suffix_of(node_reference leaf) const { return leaf_num_of(leaf); }
+
+    // Length of string from root to node.
+    int32_t string_depth(node_reference node) const;
+
+    // Parent of inner node, '-1' for root.
+    node_reference parent(node_reference node) const { return get_node_by(node).parent; }
+
+    // Range of lexicographic leaf numbers of inner node: [first, second).
+    std::pair<int32_t, int32_t> leaf_range(node_reference node) const { return {get_node_by(node).leaf_begin, get_node_by(node).leaf_end}; }
+
+    // Childs of inner node are passed to `callback(node_reference child, std::string_view label)`, label is substring of edge.
+    template <typename Callback>
+    void for_each_child(node_reference node, Callback&& callback) const;
+
+    /**
+     * @brief Depth-first traversal of subtree in lexicographic order
+     * 
+     * Traversal is iterative, so deep trees don't overflow stack.
+     * 
+     * @param from inner node, root of subtree
+     * @param enter called as `enter(node_reference node, std::string_view label)` before childs of node, label 
+     *  is substring of edge which comes to node (empty for root); if it returns `bool`, false skips childs
+     * @param leave called as `leave(node_reference node)` after childs of node (skipped or not)
+     */
+    template <typename Enter, typename Leave>
+    void traverse(node_reference from, Enter&& enter, Leave&& leave) const;
+
 private:
     // entry point to tree building
     void construct_tree();
 
+    // define parents, string depths and lexicographic leaf ranges of inner nodes
+    void annotate_tree();
+
     // create dummy node - suffix connection of root
     reference_to_node create_dummy_node();
 
@@ -191,8 +403,11 @@ private:
     Node& get_node_by(reference_to_node ref) { return node_allocator[ref]; }
 
     // abstractions over leafs, leafs is just negative references
-    bool is_leaf(reference_to_node ref) const { return ref < 0; }
     int32_t leaf_num_of(reference_to_node ref) const;
+    reference_to_node allocate_leaf() { return -(++leafs_count); }
+
+    // range of lexicographic leaf numbers below edge which comes from node
+    std::pair<int32_t, int32_t> leaf_range_of(reference_to_node node_addr, reference_to_edge edge_addr) const;
 
     // methods to access dummy node (suffix connection of root node)
     reference_to_node get_dummy() const { return get_node_by(root_addr).suffix_connection; }
@@ -214,6 +429,93 @@ private:
 private:
     std::vector<Node> node_allocator;
     std::vector<Edge> edge_allocator;
+    int32_t leafs_count = 0;
+
+private:
+    // start positions of suffixes in lexicographic order of leafs
+    std::vector<int32_t> suffix_array;
+};
+
+
+/**
+ * @brief Position inside suffix tree
+ * 
+ * Cursor points to the end of some substring of source and allows to extend and retract this 
+ * substring letter by letter. Each operation costs O(1), so pattern which grows by one letter 
+ * per step doesn't require to repeat search from the root. Cursor is lightweight and can be 
+ * copied freely, but must not outlive tree.
+ */
+template <typename Alphabet>
+class SuffixTree<Alphabet>::Cursor
+{
+public:
+    // Creates cursor which points to empty substring (root of tree).
+    explicit Cursor(const SuffixTree& tree) : tree(&tree), iterator{tree.root_addr, no_connection, 0} {}
+
+    /**
+     * @brief Extends matched substring with one letter
+     * 
+     * @param ch letter to append
+     * @returns true if extended substring exists in source and false otherwise (cursor is unchanged)
+     */
+    bool extend(char ch);
+
+    /**
+     * @brief Extends matched substring with string letter by letter
+     * 
+     * @param str letters to append
+     * @returns count of appended letters, cursor stops before first letter which can't be appended
+     */
+    size_t extend(std::string_view str);
+
+    /**
+     * @brief Removes last letter of matched substring
+     * 
+     * @returns false if matched substring is already empty and true otherwise
+     */
+    bool retract();
+
+    /**
+     * @brief Removes first letter of matched substring
+     * 
+     * Cursor goes by suffix connection and then skips edges by their lengths. Cost of skips is 
+     * amortized by extensions, so sliding window over text costs O(1) per letter.
+     * 
+     * @returns false if matched substring is already empty and true otherwise
+     */
+    bool drop_first();
+
+    // Length of matched substring.
+    int32_t length() const { return depth; }
+
+    // Count of occurrences of matched substring in source.
+    int32_t count() const;
+
+    // Range of lexicographic leaf numbers of matched substring: [first, second), leaf of terminal is never included.
+    std::pair<int32_t, int32_t> leaf_range() const;
+
+    // Position of first occurrence of matched substring.
+    int32_t first_position() const;
+
+    // The closest node at the end of matched substring or below it.
+    node_reference node() const;
+
+    // The closest inner node at the end of matched substring or above it.
+    node_reference upper_node() const { return iterator.node_addr; }
+
+    // Letters which can extend matched substring.
+    std::vector<char> children() const;
+
+    // Letters which can extend matched substring are passed to `sink(char)`, returns false if stopped by sink.
+    template <typename Sink>
+    bool children(Sink&& sink) const;
+
+private:
+    friend class SuffixTree;
+
+    const SuffixTree* tree;
+    InnerPosition iterator;
+    int32_t depth = 0;
 };
 
 
@@ -295,16 +597,15 @@ SuffixTree<Alphabet>::SuffixTree(std::string_view source) : expanded_string(std:
 
     // do main routine and construct suffix tree
     construct_tree();
+
+    // prepare tree to queries
+    annotate_tree();
 }
 
 
 template<typename Alphabet>
 void SuffixTree<Alphabet>::go_using_suffix_connection(InnerPosition& iterator) const
 {
-    // save source edge which contains current position to take chars to jump from it
-    const Edge& source_edge = get_edge_by(iterator.edge_addr);
-    assert(source_edge.start_position >= 0);
-
     // jump to node by suffix connection
     iterator.node_addr = get_node_by(iterator.node_addr).suffix_connection;
     if(iterator.position == 0)
@@ -313,6 +614,10 @@ void SuffixTree<Alphabet>::go_using_suffix_connection(InnerPosition& iterator) c
         return;
     }
 
+    // save source edge which contains current position to take chars to jump from it
+    const Edge& source_edge = get_edge_by(iterator.edge_addr);
+    assert(source_edge.start_position >= 0);
+
     // update edge
     {
         const Node& node = get_node_by(iterator.node_addr);
@@ -437,8 +742,7 @@ typename SuffixTree<Alphabet>::reference_to_node SuffixTree<Alphabet>::add_node_
 template <typename Alphabet>
 void SuffixTree<Alphabet>::create_new_edge_to_leaf_from_node(uint32_t new_ch_pos, reference_to_node node_addr)
 {
-    static reference_to_node leaf_addr_allocator = 0;
-    reference_to_node new_leaf_addr = --leaf_addr_allocator;
+    reference_to_node new_leaf_addr = allocate_leaf();
 
     Node& node = get_node_by(node_addr);
     char ch = expanded_string[new_ch_pos];
@@ -543,73 +847,754 @@ void SuffixTree<Alphabet>::construct_tree()
 }
 
 
+template <typename Alphabet>
+void SuffixTree<Alphabet>::annotate_tree()
+{
+    suffix_array.reserve(leafs_count);
+
+    // iterative dfs in lexicographic order, each stack item is node and index of next edge to visit
+    std::vector<std::pair<reference_to_node, int32_t>> stack;
+    stack.emplace_back(root_addr, 0);
+
+    while(!stack.empty())
+    {
+        auto& [node_addr, edge_idx] = stack.back();
+        Node& node = get_node_by(node_addr);
+
+        // skip absent edges
+        while(edge_idx < Alphabet::size() && node.edges_to_childs[edge_idx] == no_connection)
+            ++edge_idx;
+
+        // all childs are processed
+        if(edge_idx == Alphabet::size())
+        {
+            node.leaf_end = suffix_array.size();
+            stack.pop_back();
+            continue;
+        }
+
+        reference_to_edge edge_addr = node.edges_to_childs[edge_idx++];
+        reference_to_node child_addr = get_edge_by(edge_addr).next_node_addr;
+
+        // leafs are allocated in order of suffixes, so leaf number is start position of suffix
+        if(is_leaf(child_addr))
+        {
+            suffix_array.push_back(leaf_num_of(child_addr));
+            continue;
+        }
+
+        Node& child = get_node_by(child_addr);
+        {
+            child.parent = node_addr;
+            child.incoming_edge = edge_addr;
+            child.leaf_begin = suffix_array.size();
+            child.string_depth = node.string_depth + get_edge_by(edge_addr).length;
+        }
+        stack.emplace_back(child_addr, 0);
+    }
+
+    assert(static_cast<int32_t>(suffix_array.size()) == leafs_count);
+}
+
+
+template <typename Alphabet>
+std::pair<int32_t, int32_t> SuffixTree<Alphabet>::leaf_range_of(reference_to_node node_addr, reference_to_edge edge_addr) const
+{
+    const Edge& edge = get_edge_by(edge_addr);
+    if(!is_leaf(edge.next_node_addr))
+    {
+        const Node& child = get_node_by(edge.next_node_addr);
+        return {child.leaf_begin, child.leaf_end};
+    }
+
+    // leaf has no node, so count leafs of previous siblings
+    const Node& node = get_node_by(node_addr);
+    int32_t leaf_number = node.leaf_begin;
+    for(int32_t idx = 0; idx < alphabet.index_of(expanded_string[edge.start_position]); ++idx)
+    {
+        reference_to_edge sibling_addr = node.edges_to_childs[idx];
+        if(sibling_addr == no_connection)
+            continue;
+
+        reference_to_node sibling = get_edge_by(sibling_addr).next_node_addr;
+        leaf_number += is_leaf(sibling) ? 1 : get_node_by(sibling).leaf_end - get_node_by(sibling).leaf_begin;
+    }
+
+    return {leaf_number, leaf_number + 1};
+}
+
+
+template <typename Alphabet>
+int32_t SuffixTree<Alphabet>::string_depth(node_reference node) const
+{
+    if(is_leaf(node))
+    {
+        return length_to_end_from(leaf_num_of(node));
+    }
+
+    return get_node_by(node).string_depth;
+}
+
+
+template <typename Alphabet>
+template <typename Callback>
+void SuffixTree<Alphabet>::for_each_child(node_reference node, Callback&& callback) const
+{
+    for(reference_to_edge edge_addr : get_node_by(node).edges_to_childs)
+    {
+        if(edge_addr == no_connection)
+            continue;
+
+        const Edge& edge = get_edge_by(edge_addr);
+        callback(edge.next_node_addr, std::string_view(expanded_string).substr(edge.start_position, edge.length));
+    }
+}
+
+
+template <typename Alphabet>
+template <typename Enter, typename Leave>
+void SuffixTree<Alphabet>::traverse(node_reference from, Enter&& enter, Leave&& leave) const
+{
+    assert(!is_leaf(from));
+
+    std::string_view label;
+    if(from != root_addr)
+    {
+        const Edge& edge = get_edge_by(get_node_by(from).incoming_edge);
+        label = std::string_view(expanded_string).substr(edge.start_position, edge.length);
+    }
+
+    // enter could prune subtree
+    auto visit = [&](reference_to_node node_addr, std::string_view node_label)
+    {
+        if constexpr(std::is_same_v<decltype(enter(node_addr, node_label)), bool>)
+            return enter(node_addr, node_label);
+        else
+            return enter(node_addr, node_label), true;
+    };
+
+    // each stack item is node and index of next edge to visit
+    std::vector<std::pair<reference_to_node, int32_t>> stack;
+    if(!visit(from, label))
+    {
+        leave(from);
+        return;
+    }
+    stack.emplace_back(from, 0);
+
+    while(!stack.empty())
+    {
+        auto& [node_addr, edge_idx] = stack.back();
+        const Node& node = get_node_by(node_addr);
+
+        // skip absent edges
+        while(edge_idx < Alphabet::size() && node.edges_to_childs[edge_idx] == no_connection)
+            ++edge_idx;
+
+        // all childs are processed
+        if(edge_idx == Alphabet::size())
+        {
+            reference_to_node finished = node_addr;
+            stack.pop_back();
+            leave(finished);
+            continue;
+        }
+
+        const Edge& edge = get_edge_by(node.edges_to_childs[edge_idx++]);
+        bool descend = visit(edge.next_node_addr, std::string_view(expanded_string).substr(edge.start_position, edge.length));
+
+        if(is_leaf(edge.next_node_addr) || !descend)
+            leave(edge.next_node_addr);
+        else
+            stack.emplace_back(edge.next_node_addr, 0);
+    }
+}
+
+
 template <typename Alphabet>
 int32_t SuffixTree<Alphabet>::index_of(std::string_view pattern) const
 {
-    InnerPosition iterator = {root_addr, no_connection, 0};
+    Cursor cursor(*this);
 
-    if(pattern.size() == 0) {
-        return 0;
+    if(cursor.extend(pattern) != pattern.size())
+    {
+        return -1;
     }
 
-    reference_to_node dummy_addr = get_dummy();
-    reference_to_edge last_edge_addr = get_node_by(dummy_addr).edges_to_childs.front();
+    return cursor.first_position();
+}
 
-    for(char ch : pattern)
+
+template <typename Alphabet>
+std::vector<typename SuffixTree<Alphabet>::Completion> SuffixTree<Alphabet>::top_completions(std::string_view prefix, size_t k, 
+                                                                                             int32_t min_length, int32_t max_length) const
+{
+    std::vector<Completion> completions;
+    top_completions(prefix, k, min_length, max_length, [&](const Completion& completion)
     {
-        // define node
-        const Node& node = get_node_by(iterator.node_addr);
-        
-        // define edge
-        if(iterator.edge_addr == no_connection)
+        completions.push_back(completion);
+        return true;
+    });
+
+    return completions;
+}
+
+
+template <typename Alphabet>
+template <typename Sink>
+bool SuffixTree<Alphabet>::top_completions(std::string_view prefix, size_t k, int32_t min_length, int32_t max_length, Sink&& sink) const
+{
+    Cursor cursor(*this);
+    if(k == 0 || cursor.extend(prefix) != prefix.size())
+    {
+        return true;
+    }
+
+    // candidate is edge with string depth at its end, all substrings of edge have same count
+    struct Candidate
+    {
+        int32_t count;
+        int32_t depth;
+        reference_to_edge edge_addr;
+
+        bool operator<(const Candidate& other) const
         {
-            // update edge if possible
-            iterator.edge_addr = node.edges_to_childs[alphabet.index_of(ch)];
-            if(iterator.edge_addr == no_connection)
-            {
-                return -1;
-            }
+            // most frequent first, shorter first for equal counts
+            return count != other.count ? count < other.count : depth > other.depth;
         }
-        const Edge& edge = get_edge_by(iterator.edge_addr);
-        
-        // false if encoded string on edge not matches with pattern
-        if(expanded_string[edge.start_position + iterator.position] != ch)
+    };
+
+    ScratchVector<Candidate> candidates_scratch;
+    std::vector<Candidate>& candidates = candidates_scratch.get();
+
+    auto push_candidate = [&](Candidate candidate)
+    {
+        candidates.push_back(candidate);
+        std::push_heap(candidates.begin(), candidates.end());
+    };
+
+    auto push_childs = [&](reference_to_node node_addr, int32_t depth)
+    {
+        for(reference_to_edge edge_addr : get_node_by(node_addr).edges_to_childs)
+        {
+            if(edge_addr == no_connection)
+                continue;
+
+            const Edge& edge = get_edge_by(edge_addr);
+            int32_t count = is_leaf(edge.next_node_addr) ? 1 : get_node_by(edge.next_node_addr).leaf_end - get_node_by(edge.next_node_addr).leaf_begin;
+            push_candidate({count, depth + edge.length, edge_addr});
+        }
+    };
+
+    // locus of prefix could be inside edge
+    if(cursor.iterator.position == 0)
+    {
+        push_childs(cursor.iterator.node_addr, cursor.depth);
+    }
+    else
+    {
+        const Edge& edge = get_edge_by(cursor.iterator.edge_addr);
+        int32_t depth = cursor.depth - cursor.iterator.position + edge.length;
+        push_candidate({cursor.count(), depth, cursor.iterator.edge_addr});
+    }
+
+    size_t reported = 0;
+    while(!candidates.empty() && reported < k)
+    {
+        std::pop_heap(candidates.begin(), candidates.end());
+        Candidate candidate = candidates.back();
+        candidates.pop_back();
+
+        const Edge& edge = get_edge_by(candidate.edge_addr);
+        bool leaf = is_leaf(edge.next_node_addr);
+
+        // terminal is not a part of source, edge with terminal only continues nothing
+        int32_t length = std::min(leaf ? candidate.depth - 1 : candidate.depth, max_length);
+        bool continues = length > candidate.depth - edge.length;
+        if(continues && length > static_cast<int32_t>(prefix.size()) && length >= min_length)
         {
-            return -1;
+            int32_t position = edge.start_position + edge.length - candidate.depth;
+            if(!sink(Completion{std::string_view(expanded_string).substr(position, length), candidate.count}))
+                return false;
+
+            ++reported;
+        }
+
+        // continuations of childs are longer and not more frequent
+        if(!leaf && candidate.depth < max_length)
+        {
+            push_childs(edge.next_node_addr, candidate.depth);
         }
+    }
+
+    return true;
+}
+
+
+template <typename Alphabet>
+std::vector<int32_t> SuffixTree<Alphabet>::find_all(std::string_view pattern) const
+{
+    std::vector<int32_t> positions;
+    find_all(pattern, [&](int32_t position)
+    {
+        positions.push_back(position);
+        return true;
+    });
+
+    return positions;
+}
+
+
+template <typename Alphabet>
+template <typename Sink>
+bool SuffixTree<Alphabet>::find_all(std::string_view pattern, Sink&& sink) const
+{
+    Cursor cursor(*this);
+    if(cursor.extend(pattern) != pattern.size())
+    {
+        return true;
+    }
+
+    auto [leaf_begin, leaf_end] = cursor.leaf_range();
+    for(int32_t leaf_number = leaf_begin; leaf_number < leaf_end; ++leaf_number)
+        if(!sink(suffix_array[leaf_number]))
+            return false;
 
-        // update position
-        ++iterator.position;
+    return true;
+}
+
+
+template <typename Alphabet>
+std::vector<int32_t> SuffixTree<Alphabet>::find_all_parallel(std::string_view pattern, size_t threads_count, bool sorted) const
+{
+    // chunks smaller than this are not worth of thread synchronisation
+    static constexpr int32_t min_chunk_size = 1 << 16;
+
+    Cursor cursor(*this);
+    if(cursor.extend(pattern) != pattern.size())
+    {
+        return {};
+    }
+
+    auto [leaf_begin, leaf_end] = cursor.leaf_range();
+    int32_t count = leaf_end - leaf_begin;
+
+    // few chunks per thread to balance uneven threads
+    int32_t chunk_size = std::max<int32_t>(min_chunk_size, count / std::max<size_t>(1, threads_count * 4));
+    size_t chunks_count = (count + chunk_size - 1) / chunk_size;
+
+    std::vector<int32_t> positions(count);
+    parallel_for(chunks_count, threads_count, [&](size_t chunk_idx, size_t)
+    {
+        auto first = positions.begin() + chunk_idx * chunk_size;
+        auto last = positions.begin() + std::min<size_t>(count, (chunk_idx + 1) * chunk_size);
+        std::copy(suffix_array.begin() + leaf_begin + (first - positions.begin()), 
+                  suffix_array.begin() + leaf_begin + (last - positions.begin()), first);
+
+        if(sorted)
+            std::sort(first, last);
+    });
+
+    if(!sorted)
+    {
+        return positions;
+    }
 
-        // update node if needed
-        if(edge.length == iterator.position)
+    // merge sorted runs pairwise, runs of each round are merged in parallel
+    std::vector<int32_t> merged(count);
+    for(size_t run_size = chunk_size; run_size < static_cast<size_t>(count); run_size *= 2)
+    {
+        size_t pairs_count = (count + 2 * run_size - 1) / (2 * run_size);
+        parallel_for(pairs_count, threads_count, [&](size_t pair_idx, size_t)
         {
-            last_edge_addr = iterator.edge_addr;
+            size_t first = pair_idx * 2 * run_size;
+            size_t middle = std::min<size_t>(count, first + run_size);
+            size_t last = std::min<size_t>(count, first + 2 * run_size);
+            std::merge(positions.begin() + first, positions.begin() + middle, 
+                       positions.begin() + middle, positions.begin() + last, merged.begin() + first);
+        });
+
+        positions.swap(merged);
+    }
 
-            iterator.node_addr = edge.next_node_addr;
-            iterator.edge_addr = no_connection;
-            iterator.position = 0;
+    return positions;
+}
+
+
+template <typename Alphabet>
+std::vector<int32_t> SuffixTree<Alphabet>::sample_occurrences(std::string_view pattern, size_t k, SampleMode mode, uint32_t seed) const
+{
+    std::vector<int32_t> positions;
+    sample_occurrences(pattern, k, mode, seed, [&](int32_t position)
+    {
+        positions.push_back(position);
+        return true;
+    });
+
+    return positions;
+}
+
+
+template <typename Alphabet>
+template <typename Sink>
+bool SuffixTree<Alphabet>::sample_occurrences(std::string_view pattern, size_t k, SampleMode mode, uint32_t seed, Sink&& sink) const
+{
+    Cursor cursor(*this);
+    if(k == 0 || cursor.extend(pattern) != pattern.size())
+    {
+        return true;
+    }
+
+    auto [leaf_begin, leaf_end] = cursor.leaf_range();
+    int32_t count = leaf_end - leaf_begin;
+
+    if(mode == SampleMode::random)
+    {
+        int32_t samples = std::min<size_t>(k, count);
+
+        // open addressing set of chosen leaf numbers, filled at most by half
+        ScratchVector<int32_t> chosen_scratch;
+        std::vector<int32_t>& chosen = chosen_scratch.get();
+        int32_t capacity = 1;
+        while(capacity < 2 * samples)
+            capacity <<= 1;
+        chosen.assign(capacity, -1);
+
+        auto insert = [&](int32_t leaf_number)
+        {
+            int32_t slot = (leaf_number * 2654435761u) & (capacity - 1);
+            for(; chosen[slot] != -1; slot = (slot + 1) & (capacity - 1))
+                if(chosen[slot] == leaf_number)
+                    return false;
+
+            chosen[slot] = leaf_number;
+            return true;
+        };
+
+        // Floyd's algorithm: k distinct leaf numbers without enumeration of range
+        std::mt19937 generator(seed);
+        for(int32_t bound = count - samples; bound < count; ++bound)
+        {
+            int32_t leaf_number = std::uniform_int_distribution<int32_t>(0, bound)(generator);
+            if(!insert(leaf_number))
+                insert(leaf_number = bound);
+
+            if(!sink(suffix_array[leaf_begin + leaf_number]))
+                return false;
+        }
+
+        return true;
+    }
+
+    // candidate is edge with string depth at its end, first position of its subtree is known from edge
+    struct Candidate
+    {
+        int32_t position;
+        int32_t depth;
+        reference_to_edge edge_addr;
+
+        bool operator<(const Candidate& other) const { return position > other.position; }
+    };
+
+    ScratchVector<Candidate> candidates_scratch;
+    std::vector<Candidate>& candidates = candidates_scratch.get();
+
+    auto push_edge = [&](reference_to_edge edge_addr, int32_t depth)
+    {
+        const Edge& edge = get_edge_by(edge_addr);
+        candidates.push_back({edge.start_position + edge.length - depth, depth, edge_addr});
+        std::push_heap(candidates.begin(), candidates.end());
+    };
+
+    auto push_childs = [&](reference_to_node node_addr, int32_t depth)
+    {
+        for(reference_to_edge edge_addr : get_node_by(node_addr).edges_to_childs)
+            if(edge_addr != no_connection)
+                push_edge(edge_addr, depth + get_edge_by(edge_addr).length);
+    };
+
+    // locus of pattern could be inside edge
+    if(cursor.iterator.position == 0)
+    {
+        push_childs(cursor.iterator.node_addr, cursor.depth);
+    }
+    else
+    {
+        const Edge& edge = get_edge_by(cursor.iterator.edge_addr);
+        push_edge(cursor.iterator.edge_addr, cursor.depth - cursor.iterator.position + edge.length);
+    }
+
+    size_t reported = 0;
+    while(!candidates.empty() && reported < k)
+    {
+        std::pop_heap(candidates.begin(), candidates.end());
+        Candidate candidate = candidates.back();
+        candidates.pop_back();
+
+        reference_to_node next_node_addr = get_edge_by(candidate.edge_addr).next_node_addr;
+        if(is_leaf(next_node_addr))
+        {
+            // suffix of terminal doesn't start at position of source
+            if(candidate.position == suffixes_count() - 1)
+                continue;
+
+            if(!sink(candidate.position))
+                return false;
+
+            ++reported;
+            continue;
+        }
+
+        push_childs(next_node_addr, candidate.depth);
+    }
+
+    return true;
+}
+
+
+template <typename Alphabet>
+std::vector<typename SuffixTree<Alphabet>::Match> SuffixTree<Alphabet>::matching_statistics(std::string_view query) const
+{
+    std::vector<Match> matches;
+    matches.reserve(query.size());
+    matching_statistics(query, [&](size_t, const Match* chunk, size_t count)
+    {
+        matches.insert(matches.end(), chunk, chunk + count);
+        return true;
+    });
+
+    return matches;
+}
+
+
+template <typename Alphabet>
+template <typename Sink>
+bool SuffixTree<Alphabet>::matching_statistics(std::string_view query, Sink&& sink) const
+{
+    static constexpr size_t chunk_size = 4096;
+
+    ScratchVector<Match> chunk_scratch;
+    std::vector<Match>& chunk = chunk_scratch.get();
+    chunk.reserve(chunk_size);
 
-            // leaf must not be accessed due to terminal
-            assert(!is_leaf(iterator.node_addr));
+    // cursor keeps match of query[position, end)
+    Cursor cursor(*this);
+    size_t end = 0;
+
+    for(size_t position = 0; position < query.size(); ++position)
+    {
+        end += cursor.extend(query.substr(end));
+        chunk.push_back({cursor.length(), cursor.first_position()});
+
+        if(chunk.size() == chunk_size || position + 1 == query.size())
+        {
+            if(!sink(position + 1 - chunk.size(), chunk.data(), chunk.size()))
+                return false;
+
+            chunk.clear();
         }
+
+        // empty match is kept by skipping of letter which doesn't occur in source
+        if(!cursor.drop_first())
+            ++end;
+    }
+
+    return true;
+}
+
+
+template <typename Alphabet>
+bool SuffixTree<Alphabet>::Cursor::extend(char ch)
+{
+    // terminal is not a part of source
+    int32_t ch_idx = alphabet.index_of(ch);
+    if(ch_idx < 0 || ch == terminal_symbol)
+    {
+        return false;
+    }
+
+    // check that path by letter exists
+    if(iterator.position == 0)
+    {
+        if(tree->get_node_by(iterator.node_addr).edges_to_childs[ch_idx] == no_connection)
+            return false;
+    }
+    else
+    {
+        const Edge& edge = tree->get_edge_by(iterator.edge_addr);
+        if(tree->expanded_string[edge.start_position + iterator.position] != ch)
+            return false;
+    }
+
+    tree->go_over_one_letter_next(ch, iterator);
+    ++depth;
+
+    // leaf must not be accessed due to terminal
+    assert(!tree->is_leaf(iterator.node_addr));
+    return true;
+}
+
+
+template <typename Alphabet>
+size_t SuffixTree<Alphabet>::Cursor::extend(std::string_view str)
+{
+    size_t appended = 0;
+    while(appended < str.size() && extend(str[appended]))
+        ++appended;
+
+    return appended;
+}
+
+
+template <typename Alphabet>
+bool SuffixTree<Alphabet>::Cursor::retract()
+{
+    if(depth == 0)
+    {
+        return false;
+    }
+
+    // if current position in inner node: step back to incoming edge
+    if(iterator.position == 0)
+    {
+        const Node& node = tree->get_node_by(iterator.node_addr);
+
+        iterator.edge_addr = node.incoming_edge;
+        iterator.node_addr = node.parent;
+        iterator.position = tree->get_edge_by(iterator.edge_addr).length;
+    }
+
+    --iterator.position;
+    --depth;
+
+    // undefine edge if node is obtained
+    if(iterator.position == 0)
+    {
+        iterator.edge_addr = no_connection;
+    }
+
+    return true;
+}
+
+
+template <typename Alphabet>
+bool SuffixTree<Alphabet>::Cursor::drop_first()
+{
+    if(depth == 0)
+    {
+        return false;
+    }
+
+    tree->go_using_suffix_connection(iterator);
+    --depth;
+
+    assert(!tree->is_leaf(iterator.node_addr));
+    return true;
+}
+
+
+template <typename Alphabet>
+int32_t SuffixTree<Alphabet>::Cursor::count() const
+{
+    auto [leaf_begin, leaf_end] = leaf_range();
+    return leaf_end - leaf_begin;
+}
+
+
+template <typename Alphabet>
+std::pair<int32_t, int32_t> SuffixTree<Alphabet>::Cursor::leaf_range() const
+{
+    // empty substring occurs at each position of source, suffix of terminal is the first leaf
+    if(depth == 0)
+    {
+        return {1, tree->suffixes_count()};
+    }
+
+    if(iterator.position == 0)
+    {
+        const Node& node = tree->get_node_by(iterator.node_addr);
+        return {node.leaf_begin, node.leaf_end};
+    }
+
+    return tree->leaf_range_of(iterator.node_addr, iterator.edge_addr);
+}
+
+
+template <typename Alphabet>
+int32_t SuffixTree<Alphabet>::Cursor::first_position() const
+{
+    if(depth == 0)
+    {
+        return 0;
     }
 
     reference_to_edge edge_addr = iterator.edge_addr;
     int32_t edge_position = iterator.position;
 
-    // use last edge if current position in node
-    if(iterator.edge_addr == no_connection)
+    // use incoming edge if current position in node
+    if(iterator.position == 0)
     {
-        edge_addr = last_edge_addr;
-        edge_position = get_edge_by(edge_addr).length;
+        edge_addr = tree->get_node_by(iterator.node_addr).incoming_edge;
+        edge_position = tree->get_edge_by(edge_addr).length;
     }
 
-    // define position of first occurence
-    const Edge& edge = get_edge_by(edge_addr);
-    int32_t position = edge.start_position + edge_position - pattern.size();
+    // edges keep position of first occurrence of their substring
+    const Edge& edge = tree->get_edge_by(edge_addr);
+    int32_t position = edge.start_position + edge_position - depth;
     assert(position >= 0);
     return position;
 }
 
+
+template <typename Alphabet>
+typename SuffixTree<Alphabet>::node_reference SuffixTree<Alphabet>::Cursor::node() const
+{
+    if(iterator.position == 0)
+    {
+        return iterator.node_addr;
+    }
+
+    return tree->get_edge_by(iterator.edge_addr).next_node_addr;
+}
+
+
+template <typename Alphabet>
+std::vector<char> SuffixTree<Alphabet>::Cursor::children() const
+{
+    std::vector<char> letters;
+    children([&](char ch)
+    {
+        letters.push_back(ch);
+        return true;
+    });
+
+    return letters;
+}
+
+
+template <typename Alphabet>
+template <typename Sink>
+bool SuffixTree<Alphabet>::Cursor::children(Sink&& sink) const
+{
+    // inside edge only one letter is possible
+    if(iterator.position != 0)
+    {
+        const Edge& edge = tree->get_edge_by(iterator.edge_addr);
+        char ch = tree->expanded_string[edge.start_position + iterator.position];
+        return ch == terminal_symbol || sink(ch);
+    }
+
+    for(reference_to_edge edge_addr : tree->get_node_by(iterator.node_addr).edges_to_childs)
+    {
+        if(edge_addr == no_connection)
+            continue;
+
+        char ch = tree->expanded_string[tree->get_edge_by(edge_addr).start_position];
+        if(ch != terminal_symbol && !sink(ch))
+            return false;
+    }
+
+    return true;
+}
+
 } // custom
@@ -0,0 +1,329 @@
+#pragma once
+
+#include "GeneralizedSuffixTree.h"
+
+#include <unordered_map>
+#include <set>
+
+namespace custom
+{
+
+/**
+ * @brief Top-k document retrieval by term frequency
+ *
+ * Every `granularity`-th leaf is marked and nodes which have marked leafs in at least two child
+ * subtrees are sampled, so count of sampled nodes is O(n / granularity). Each sampled node keeps
+ * `max_k` most frequent documents of its subtree. Frequencies are built bottom-up in one post-order
+ * pass: the smaller table of documents of child is merged into the larger one of parent and table
+ * keeps documents ordered by frequency, so each leaf is moved O(log n) times and the list of sampled
+ * node is read in O(max_k). Build costs O(n log^2 n) whatever nesting of sampled nodes is.
+ *
+ * For query locus highest sampled node of its subtree covers all leafs except less than
+ * 2 * granularity ones. Document which isn't in list of sampled node and doesn't occur in uncovered
+ * leafs can't be more frequent than documents of the list, so candidates are documents of list and
+ * of uncovered leafs. Exact frequencies of candidates are taken by binary search over sorted leaf
+ * numbers of each document. Query costs O(m + d σ + granularity log n + k log k), where d is count of
+ * nodes between locus and the highest sampled node of its subtree (they have all marked leafs in one
+ * child). If k is larger than `max_k` or locus has less than two marked leafs, all occurrences are
+ * counted instead, which costs O(m + occ + k log k).
+ */
+template <typename Alphabet=StandartGeneralizedSuffixTreeAlphabet>
+class TopDocumentsIndex
+{
+public:
+    struct DocumentFrequency
+    {
+        int32_t document;
+        int32_t frequency;
+    };
+
+public:
+    /**
+     * @param documents generalized tree which must outlive index
+     * @param granularity distance between marked leafs: larger value saves memory and costs more time per query
+     * @param max_k max count of documents which are answered by stored lists, larger k is answered by
+     *  counting of all occurrences
+     */
+    TopDocumentsIndex(const GeneralizedSuffixTree<Alphabet>& documents, int32_t granularity = 64, int32_t max_k = 16);
+
+    /**
+     * @brief Documents where pattern occurs most often
+     *
+     * @param pattern string to match as substring
+     * @param k max count of documents
+     * @returns documents with frequencies in descending order of frequency
+     */
+    std::vector<DocumentFrequency> top_documents(std::string_view pattern, size_t k) const;
+
+    // Documents are passed to `sink(const DocumentFrequency&)` in descending order of frequency, returns false if stopped by sink.
+    template <typename Sink>
+    bool top_documents(std::string_view pattern, size_t k, Sink&& sink) const;
+
+private:
+    using node_reference = typename SuffixTree<Alphabet>::node_reference;
+
+    // count of leafs of document in range [leaf_begin, leaf_end)
+    int32_t frequency(int32_t document, int32_t leaf_begin, int32_t leaf_end) const;
+
+    // frequencies of documents of leaf range, unordered
+    void count_documents(int32_t leaf_begin, int32_t leaf_end, std::vector<DocumentFrequency>& frequencies) const;
+
+    // orders frequencies from the most frequent and keeps k of them
+    static void keep_top(std::vector<DocumentFrequency>& frequencies, size_t k);
+
+private:
+    const GeneralizedSuffixTree<Alphabet>& documents;
+    int32_t granularity;
+    int32_t max_k;
+
+    // leaf numbers of each document in ascending order: leafs of document 'd' are in range [offsets[d], offsets[d + 1])
+    std::vector<int32_t> document_leafs;
+    std::vector<int32_t> document_offsets;
+
+    // range of stored list for each sampled node
+    std::unordered_map<node_reference, std::pair<int32_t, int32_t>> sampled_nodes;
+    std::vector<DocumentFrequency> stored_lists;
+};
+
+
+template <typename Alphabet>
+TopDocumentsIndex<Alphabet>::TopDocumentsIndex(const GeneralizedSuffixTree<Alphabet>& documents, int32_t granularity, int32_t max_k)
+    : documents(documents), granularity(std::max(granularity, 1)), max_k(max_k)
+{
+    const SuffixTree<Alphabet>& tree = documents.tree();
+
+    // group leaf numbers by documents with counting sort
+    document_offsets.assign(documents.documents_count() + 1, 0);
+    for(int32_t leaf_number = 0; leaf_number < tree.suffixes_count(); ++leaf_number)
+        ++document_offsets[documents.document_at(leaf_number) + 1];
+
+    for(int32_t document = 0; document < documents.documents_count(); ++document)
+        document_offsets[document + 1] += document_offsets[document];
+
+    document_leafs.resize(tree.suffixes_count());
+    std::vector<int32_t> filled(document_offsets.begin(), document_offsets.end() - 1);
+    for(int32_t leaf_number = 0; leaf_number < tree.suffixes_count(); ++leaf_number)
+        document_leafs[filled[documents.document_at(leaf_number)]++] = leaf_number;
+
+    // post-order pass: count child subtrees with marked leafs and merge frequencies of documents
+    struct Frame
+    {
+        node_reference node;
+        int32_t marked_childs = 0;
+
+        // frequency of each document of subtree and documents ordered from the most frequent
+        std::unordered_map<int32_t, int32_t> frequencies;
+        std::set<std::pair<int32_t, int32_t>> by_frequency;
+
+        void add(int32_t document, int32_t count)
+        {
+            int32_t& frequency = frequencies[document];
+            if(frequency > 0)
+                by_frequency.erase({-frequency, document});
+
+            frequency += count;
+            by_frequency.insert({-frequency, document});
+        }
+
+        // smaller table is merged into larger one
+        void merge(Frame& child)
+        {
+            if(child.frequencies.size() > frequencies.size())
+            {
+                frequencies.swap(child.frequencies);
+                by_frequency.swap(child.by_frequency);
+            }
+
+            for(auto [document, count] : child.frequencies)
+                add(document, count);
+        }
+    };
+
+    std::vector<Frame> frames;
+    int32_t leaf_number = 0;
+
+    tree.traverse(tree.root(), [&](node_reference node, std::string_view)
+    {
+        if(!tree.is_leaf(node))
+            frames.push_back(Frame{node});
+    },
+    [&](node_reference node)
+    {
+        if(tree.is_leaf(node))
+        {
+            if(!frames.empty() && leaf_number % this->granularity == 0)
+                ++frames.back().marked_childs;
+
+            if(!frames.empty())
+                frames.back().add(documents.document_at(leaf_number), 1);
+
+            ++leaf_number;
+            return;
+        }
+
+        Frame frame = std::move(frames.back());
+        frames.pop_back();
+
+        if(frame.marked_childs >= 2)
+        {
+            size_t list_begin = stored_lists.size();
+            for(auto [negative_frequency, document] : frame.by_frequency)
+            {
+                if(stored_lists.size() - list_begin == static_cast<size_t>(this->max_k))
+                    break;
+
+                stored_lists.push_back({document, -negative_frequency});
+            }
+
+            sampled_nodes[node] = {list_begin, stored_lists.size()};
+        }
+
+        if(!frames.empty())
+        {
+            if(frame.marked_childs > 0)
+                ++frames.back().marked_childs;
+
+            frames.back().merge(frame);
+        }
+    });
+}
+
+
+template <typename Alphabet>
+int32_t TopDocumentsIndex<Alphabet>::frequency(int32_t document, int32_t leaf_begin, int32_t leaf_end) const
+{
+    auto first = document_leafs.begin() + document_offsets[document];
+    auto last = document_leafs.begin() + document_offsets[document + 1];
+    return std::lower_bound(first, last, leaf_end) - std::lower_bound(first, last, leaf_begin);
+}
+
+
+template <typename Alphabet>
+void TopDocumentsIndex<Alphabet>::count_documents(int32_t leaf_begin, int32_t leaf_end, std::vector<DocumentFrequency>& frequencies) const
+{
+    // counters are reused between calls, only touched ones are reset; nothing is called back while they
+    // are in use, so nested queries can't meet non-zero counters
+    static thread_local std::vector<int32_t> counters;
+    counters.resize(std::max<size_t>(counters.size(), documents.documents_count()), 0);
+
+    frequencies.clear();
+    for(int32_t leaf_number = leaf_begin; leaf_number < leaf_end; ++leaf_number)
+    {
+        int32_t document = documents.document_at(leaf_number);
+        if(counters[document]++ == 0)
+            frequencies.push_back({document, 0});
+    }
+
+    for(DocumentFrequency& document_frequency : frequencies)
+    {
+        document_frequency.frequency = counters[document_frequency.document];
+        counters[document_frequency.document] = 0;
+    }
+}
+
+
+template <typename Alphabet>
+void TopDocumentsIndex<Alphabet>::keep_top(std::vector<DocumentFrequency>& frequencies, size_t k)
+{
+    k = std::min(k, frequencies.size());
+    std::partial_sort(frequencies.begin(), frequencies.begin() + k, frequencies.end(), [](const auto& lhs, const auto& rhs)
+    {
+        return lhs.frequency != rhs.frequency ? lhs.frequency > rhs.frequency : lhs.document < rhs.document;
+    });
+
+    frequencies.resize(k);
+}
+
+
+template <typename Alphabet>
+std::vector<typename TopDocumentsIndex<Alphabet>::DocumentFrequency> TopDocumentsIndex<Alphabet>::top_documents(std::string_view pattern, size_t k) const
+{
+    std::vector<DocumentFrequency> result;
+    top_documents(pattern, k, [&](const DocumentFrequency& document_frequency)
+    {
+        result.push_back(document_frequency);
+        return true;
+    });
+
+    return result;
+}
+
+
+template <typename Alphabet>
+template <typename Sink>
+bool TopDocumentsIndex<Alphabet>::top_documents(std::string_view pattern, size_t k, Sink&& sink) const
+{
+    const SuffixTree<Alphabet>& tree = documents.tree();
+
+    // empty pattern and pattern with separator doesn't belong to any document
+    typename SuffixTree<Alphabet>::Cursor cursor(tree);
+    bool valid = !pattern.empty() && pattern.find(document_separator) == std::string_view::npos;
+    if(k == 0 || !valid || cursor.extend(pattern) != pattern.size())
+    {
+        return true;
+    }
+
+    auto [leaf_begin, leaf_end] = cursor.leaf_range();
+
+    ScratchVector<DocumentFrequency> candidates_scratch;
+    std::vector<DocumentFrequency>& candidates = candidates_scratch.get();
+
+    // marked leafs of range
+    int32_t first_marked = (leaf_begin + granularity - 1) / granularity * granularity;
+    int32_t last_marked = (leaf_end - 1) / granularity * granularity;
+
+    if(k > static_cast<size_t>(max_k) || first_marked >= last_marked)
+    {
+        // lists can't answer query or range is small
+        count_documents(leaf_begin, leaf_end, candidates);
+    }
+    else
+    {
+        // all marked leafs of range are in one child subtree until sampled node is obtained
+        node_reference node = cursor.node();
+        while(sampled_nodes.count(node) == 0)
+        {
+            tree.for_each_child(node, [&](node_reference child, std::string_view)
+            {
+                if(tree.is_leaf(child))
+                    return;
+
+                auto [child_begin, child_end] = tree.leaf_range(child);
+                if(child_begin <= first_marked && first_marked < child_end)
+                    node = child;
+            });
+        }
+
+        auto [list_begin, list_end] = sampled_nodes.at(node);
+        auto [covered_begin, covered_end] = tree.leaf_range(node);
+
+        candidates.assign(stored_lists.begin() + list_begin, stored_lists.begin() + list_end);
+        for(int32_t leaf_number = leaf_begin; leaf_number < leaf_end; ++leaf_number)
+        {
+            if(leaf_number == covered_begin)
+                leaf_number = covered_end;
+
+            if(leaf_number < leaf_end)
+                candidates.push_back({documents.document_at(leaf_number), 0});
+        }
+
+        // exact frequencies of distinct candidates
+        std::sort(candidates.begin(), candidates.end(), [](const auto& lhs, const auto& rhs) { return lhs.document < rhs.document; });
+        candidates.erase(std::unique(candidates.begin(), candidates.end(), [](const auto& lhs, const auto& rhs)
+        {
+            return lhs.document == rhs.document;
+        }), candidates.end());
+
+        for(DocumentFrequency& candidate : candidates)
+            candidate.frequency = frequency(candidate.document, leaf_begin, leaf_end);
+    }
+
+    keep_top(candidates, k);
+    for(const DocumentFrequency& document_frequency : candidates)
+        if(!sink(document_frequency))
+            return false;
+
+    return true;
+}
+
+} // custom
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cassert>
+
+namespace custom
+{
+
+/**
+ * @brief Wavelet matrix over sequence of non-negative integers
+ *
+ * Sequence is stored as one bit vector with rank support per bit of values (from the highest bit
+ * to the lowest one). On each level values are stably partitioned by current bit, so any range of
+ * sequence is mapped to one range on the next level for each bit value. It allows to count and
+ * enumerate values of range which lie in some interval in O(log σ) per query and per reported value.
+ */
+class WaveletMatrix
+{
+public:
+    WaveletMatrix() = default;
+    WaveletMatrix(const std::vector<int32_t>& values);
+
+    // Count of values in range of sequence [begin, end) which are in interval [low, high).
+    int32_t count(int32_t begin, int32_t end, int32_t low, int32_t high) const;
+
+    /**
+     * @brief Enumeration of values
+     *
+     * @param begin, end range of sequence
+     * @param low, high interval of values
+     * @param callback called for each value of range which is in interval, values are reported
+     *  in ascending order, callback returns false to stop enumeration
+     * @returns false if enumeration was stopped by callback
+     */
+    template <typename Callback>
+    bool for_each(int32_t begin, int32_t end, int32_t low, int32_t high, Callback&& callback) const;
+
+private:
+    /**
+     * @brief Bit vector with constant time rank
+     *
+     * For each 64-bit word count of ones before it is stored.
+     */
+    struct BitVector
+    {
+        std::vector<uint64_t> words;
+        std::vector<int32_t> ones_before;
+
+        void build(const std::vector<bool>& bits);
+        int32_t rank1(int32_t pos) const;
+        int32_t rank0(int32_t pos) const { return pos - rank1(pos); }
+    };
+
+private:
+    // count of values in range [begin, end) which are less than value
+    int32_t count_less(int32_t begin, int32_t end, int32_t value) const;
+
+    template <typename Callback>
+    bool for_each(int32_t level, int32_t begin, int32_t end, int32_t prefix, int32_t low, int32_t high, Callback& callback) const;
+
+private:
+    int32_t bits_count = 0;
+    std::vector<BitVector> levels;
+    std::vector<int32_t> zeros_count;
+};
+
+
+inline void WaveletMatrix::BitVector::build(const std::vector<bool>& bits)
+{
+    words.assign(bits.size() / 64 + 1, 0);
+    ones_before.assign(words.size(), 0);
+
+    for(size_t pos = 0; pos < bits.size(); ++pos)
+        if(bits[pos])
+            words[pos / 64] |= uint64_t(1) << (pos % 64);
+
+    for(size_t word = 1; word < words.size(); ++word)
+        ones_before[word] = ones_before[word - 1] + __builtin_popcountll(words[word - 1]);
+}
+
+
+inline int32_t WaveletMatrix::BitVector::rank1(int32_t pos) const
+{
+    uint64_t mask = (uint64_t(1) << (pos % 64)) - 1;
+    return ones_before[pos / 64] + __builtin_popcountll(words[pos / 64] & mask);
+}
+
+
+inline WaveletMatrix::WaveletMatrix(const std::vector<int32_t>& values)
+{
+    // define count of bits required for the largest value
+    int32_t max_value = 0;
+    for(int32_t value : values)
+    {
+        assert(value >= 0);
+        max_value = std::max(max_value, value);
+    }
+
+    while(bits_count < 31 && (max_value >> bits_count) != 0)
+        ++bits_count;
+
+    levels.resize(bits_count);
+    zeros_count.resize(bits_count);
+
+    std::vector<int32_t> current = values;
+    std::vector<int32_t> next(values.size());
+    std::vector<bool> bits(values.size());
+
+    for(int32_t level = 0; level < bits_count; ++level)
+    {
+        int32_t bit = bits_count - level - 1;
+
+        for(size_t pos = 0; pos < current.size(); ++pos)
+            bits[pos] = (current[pos] >> bit) & 1;
+
+        levels[level].build(bits);
+
+        // stable partition: zeros first
+        size_t filled = 0;
+        for(size_t pos = 0; pos < current.size(); ++pos)
+            if(!bits[pos])
+                next[filled++] = current[pos];
+
+        zeros_count[level] = filled;
+
+        for(size_t pos = 0; pos < current.size(); ++pos)
+            if(bits[pos])
+                next[filled++] = current[pos];
+
+        current.swap(next);
+    }
+}
+
+
+inline int32_t WaveletMatrix::count_less(int32_t begin, int32_t end, int32_t value) const
+{
+    if(value <= 0)
+        return 0;
+
+    if(bits_count < 31 && (value >> bits_count) != 0)
+        return end - begin;
+
+    int32_t less = 0;
+    for(int32_t level = 0; level < bits_count && begin < end; ++level)
+    {
+        const BitVector& bits = levels[level];
+        int32_t zeros_begin = bits.rank0(begin), zeros_end = bits.rank0(end);
+
+        if((value >> (bits_count - level - 1)) & 1)
+        {
+            // all values with zero bit are less
+            less += zeros_end - zeros_begin;
+            begin = zeros_count[level] + (begin - zeros_begin);
+            end = zeros_count[level] + (end - zeros_end);
+        }
+        else
+        {
+            begin = zeros_begin;
+            end = zeros_end;
+        }
+    }
+
+    return less;
+}
+
+
+inline int32_t WaveletMatrix::count(int32_t begin, int32_t end, int32_t low, int32_t high) const
+{
+    if(begin >= end || low >= high)
+        return 0;
+
+    return count_less(begin, end, high) - count_less(begin, end, low);
+}
+
+
+template <typename Callback>
+bool WaveletMatrix::for_each(int32_t begin, int32_t end, int32_t low, int32_t high, Callback&& callback) const
+{
+    if(begin >= end || low >= high)
+        return true;
+
+    return for_each(0, begin, end, 0, low, high, callback);
+}
+
+
+template <typename Callback>
+bool WaveletMatrix::for_each(int32_t level, int32_t begin, int32_t end, int32_t prefix, int32_t low, int32_t high, Callback& callback) const
+{
+    if(begin >= end)
+        return true;
+
+    // skip if values of this subrange are out of interval
+    int64_t min_value = int64_t(prefix) << (bits_count - level);
+    int64_t max_value = min_value + (int64_t(1) << (bits_count - level));
+    if(max_value <= low || min_value >= high)
+        return true;
+
+    // all values on the last level are equal
+    if(level == bits_count)
+    {
+        for(int32_t pos = begin; pos < end; ++pos)
+            if(!callback(prefix))
+                return false;
+
+        return true;
+    }
+
+    const BitVector& bits = levels[level];
+    int32_t zeros_begin = bits.rank0(begin), zeros_end = bits.rank0(end);
+    int32_t ones_begin = zeros_count[level] + (begin - zeros_begin);
+    int32_t ones_end = zeros_count[level] + (end - zeros_end);
+
+    return for_each(level + 1, zeros_begin, zeros_end, prefix << 1, low, high, callback) &&
+           for_each(level + 1, ones_begin, ones_end, (prefix << 1) | 1, low, high, callback);
+}
+
+} // namespace custom
@@ -0,0 +1,316 @@
+#pragma once
+
+#include "SuffixTree.h"
+
+#include <bitset>
+
+namespace custom
+{
+
+/**
+ * @brief Pattern with don't care positions and classes of letters
+ *
+ * Syntax:
+ * 1. `?` matches any letter.
+ * 2. `[...]` matches one letter of class, class could contain ranges `a-z` and starts with `^` for
+ *    negation, e.g. `[^0-9]`.
+ * 3. `\` escapes next letter, any other letter matches itself.
+ *
+ * Each position is compiled to bit set over indices of alphabet. Terminal symbol never matches.
+ */
+template <typename Alphabet=StandartSuffixTreeAlphabet>
+class WildcardPattern
+{
+public:
+    using LetterSet = std::bitset<Alphabet::size()>;
+
+public:
+    WildcardPattern(std::string_view pattern);
+
+    // Count of letters of matched strings.
+    int32_t size() const { return classes.size(); }
+
+    // Checks does letter match position of pattern.
+    bool matches(int32_t position, char ch) const;
+
+    // Letters allowed on position of pattern.
+    const LetterSet& letters_of(int32_t position) const { return classes[position]; }
+
+    /**
+     * @brief The longest run of positions with one allowed letter each
+     *
+     * @returns offset in pattern and string of run, empty string if pattern has no such positions
+     */
+    std::pair<int32_t, std::string> longest_literal() const;
+
+    // Position of bracket which closes class opened at position `open`, size of pattern if class is not closed.
+    static size_t class_end(std::string_view pattern, size_t open);
+
+private:
+    // class body without brackets
+    LetterSet parse_class(std::string_view body) const;
+
+    // letter which is escaped or matches itself
+    void set_letter(LetterSet& letters, char ch) const;
+
+private:
+    static inline constexpr Alphabet alphabet{};
+
+    std::vector<LetterSet> classes;
+};
+
+
+/**
+ * @brief Occurrences of wildcard pattern
+ *
+ * Tree is walked from the root and branches at positions which allow several letters, so common
+ * prefixes of candidates are checked once. If the longest literal run of pattern is selective (it
+ * has less occurrences than candidates which walk could meet before it), its occurrences are found by
+ * exact descent and each of them is verified against text instead. Each position is reported once.
+ *
+ * @param tree suffix tree
+ * @param pattern wildcard pattern, see `WildcardPattern`
+ * @param sink called as `sink(int32_t position)` in arbitrary order, returns false to stop query
+ * @returns false if query was stopped by sink
+ */
+template <typename Alphabet, typename Sink>
+bool find_wildcard(const SuffixTree<Alphabet>& tree, const WildcardPattern<Alphabet>& pattern, Sink&& sink);
+
+// Same as above, but positions are returned in ascending order.
+template <typename Alphabet>
+std::vector<int32_t> find_wildcard(const SuffixTree<Alphabet>& tree, std::string_view pattern);
+
+
+template <typename Alphabet>
+WildcardPattern<Alphabet>::WildcardPattern(std::string_view pattern)
+{
+    for(size_t idx = 0; idx < pattern.size(); ++idx)
+    {
+        LetterSet letters;
+        if(pattern[idx] == '?')
+        {
+            letters.set();
+            letters.reset(alphabet.index_of(terminal_symbol));
+        }
+        else if(pattern[idx] == '[')
+        {
+            size_t close = class_end(pattern, idx);
+            assert(close < pattern.size() && "class of letters is not closed");
+            letters = parse_class(pattern.substr(idx + 1, close - idx - 1));
+            idx = close;
+        }
+        else
+        {
+            if(pattern[idx] == '\\' && idx + 1 < pattern.size())
+                ++idx;
+
+            set_letter(letters, pattern[idx]);
+        }
+
+        classes.push_back(letters);
+    }
+}
+
+
+template <typename Alphabet>
+size_t WildcardPattern<Alphabet>::class_end(std::string_view pattern, size_t open)
+{
+    // closing bracket right after opening one (or after negation) is a letter of class
+    size_t close = open + 1;
+    if(close < pattern.size() && pattern[close] == '^')
+        ++close;
+    if(close < pattern.size() && pattern[close] == ']')
+        ++close;
+    while(close < pattern.size() && pattern[close] != ']')
+        close += pattern[close] == '\\' ? 2 : 1;
+
+    return std::min(close, pattern.size());
+}
+
+
+template <typename Alphabet>
+void WildcardPattern<Alphabet>::set_letter(LetterSet& letters, char ch) const
+{
+    // letter which isn't in alphabet can't be matched
+    if(alphabet.index_of(ch) >= 0 && ch != terminal_symbol)
+        letters.set(alphabet.index_of(ch));
+}
+
+
+template <typename Alphabet>
+typename WildcardPattern<Alphabet>::LetterSet WildcardPattern<Alphabet>::parse_class(std::string_view body) const
+{
+    bool negation = !body.empty() && body[0] == '^';
+    if(negation)
+        body.remove_prefix(1);
+
+    LetterSet letters;
+    for(size_t idx = 0; idx < body.size(); ++idx)
+    {
+        if(body[idx] == '\\' && idx + 1 < body.size())
+            ++idx;
+
+        unsigned char first = body[idx], last = body[idx];
+        if(idx + 2 < body.size() && body[idx + 1] == '-')
+        {
+            idx += 2;
+            if(body[idx] == '\\' && idx + 1 < body.size())
+                ++idx;
+
+            last = body[idx];
+        }
+
+        for(int32_t ch = first; ch <= last; ++ch)
+            set_letter(letters, static_cast<char>(ch));
+    }
+
+    if(negation)
+    {
+        letters.flip();
+        letters.reset(alphabet.index_of(terminal_symbol));
+    }
+
+    return letters;
+}
+
+
+template <typename Alphabet>
+bool WildcardPattern<Alphabet>::matches(int32_t position, char ch) const
+{
+    int32_t ch_idx = alphabet.index_of(ch);
+    return ch_idx >= 0 && classes[position].test(ch_idx);
+}
+
+
+template <typename Alphabet>
+std::pair<int32_t, std::string> WildcardPattern<Alphabet>::longest_literal() const
+{
+    int32_t best_offset = 0, best_length = 0;
+    for(int32_t begin = 0, end = 0; begin < size(); begin = std::max(end, begin + 1))
+    {
+        for(end = begin; end < size() && classes[end].count() == 1; ++end);
+
+        if(end - begin > best_length)
+        {
+            best_offset = begin;
+            best_length = end - begin;
+        }
+    }
+
+    // letters of run are restored by their indices
+    std::string literal;
+    for(int32_t position = best_offset; position < best_offset + best_length; ++position)
+    {
+        for(int32_t ch = 0; ch < Alphabet::max_alphabet_size; ++ch)
+            if(matches(position, static_cast<char>(ch)))
+                literal += static_cast<char>(ch);
+    }
+
+    return {best_offset, literal};
+}
+
+
+template <typename Alphabet, typename Sink>
+bool find_wildcard(const SuffixTree<Alphabet>& tree, const WildcardPattern<Alphabet>& pattern, Sink&& sink)
+{
+    using node_reference = typename SuffixTree<Alphabet>::node_reference;
+
+    int32_t length = pattern.size();
+    int32_t text_size = tree.suffixes_count() - 1;
+    auto [offset, literal] = pattern.longest_literal();
+
+    // count of candidates which walk could meet before literal
+    int64_t walk_candidates = 1;
+    for(int32_t position = 0; position < offset && walk_candidates < text_size; ++position)
+        walk_candidates *= pattern.letters_of(position).count();
+
+    // pattern can't occur without its literal
+    typename SuffixTree<Alphabet>::Cursor cursor(tree);
+    if(cursor.extend(literal) != literal.size())
+    {
+        return true;
+    }
+
+    if(offset > 0 && !literal.empty() && cursor.count() < std::min<int64_t>(walk_candidates, text_size))
+    {
+        std::string_view text = tree.text();
+        auto [leaf_begin, leaf_end] = cursor.leaf_range();
+
+        for(int32_t leaf_number = leaf_begin; leaf_number < leaf_end; ++leaf_number)
+        {
+            int32_t start = tree.suffix_at(leaf_number) - offset;
+            if(start < 0 || start + length > text_size)
+                continue;
+
+            bool matched = true;
+            for(int32_t position = 0; position < length && matched; ++position)
+                matched = pattern.matches(position, text[start + position]);
+
+            if(matched && !sink(start))
+                return false;
+        }
+
+        return true;
+    }
+
+    // walk from the root, each stack item is node and count of matched positions
+    ScratchVector<std::pair<node_reference, int32_t>> stack_scratch;
+    std::vector<std::pair<node_reference, int32_t>>& stack = stack_scratch.get();
+    stack.assign(1, {tree.root(), 0});
+
+    bool stopped = false;
+    while(!stack.empty() && !stopped)
+    {
+        auto [node, depth] = stack.back();
+        stack.pop_back();
+
+        tree.for_each_child(node, [&](node_reference child, std::string_view label)
+        {
+            // suffix of terminal doesn't start at position of source
+            if(tree.is_leaf(child) && tree.suffix_of(child) == text_size)
+                return;
+
+            int32_t matched = depth;
+            for(size_t idx = 0; idx < label.size() && matched < length; ++idx, ++matched)
+                if(!pattern.matches(matched, label[idx]))
+                    return;
+
+            if(stopped || matched < length)
+            {
+                if(!stopped)
+                    stack.emplace_back(child, matched);
+
+                return;
+            }
+
+            if(tree.is_leaf(child))
+            {
+                stopped = !sink(tree.suffix_of(child));
+                return;
+            }
+
+            auto [leaf_begin, leaf_end] = tree.leaf_range(child);
+            for(int32_t leaf_number = leaf_begin; leaf_number < leaf_end && !stopped; ++leaf_number)
+                stopped = !sink(tree.suffix_at(leaf_number));
+        });
+    }
+
+    return !stopped;
+}
+
+
+template <typename Alphabet>
+std::vector<int32_t> find_wildcard(const SuffixTree<Alphabet>& tree, std::string_view pattern)
+{
+    std::vector<int32_t> positions;
+    find_wildcard(tree, WildcardPattern<Alphabet>(pattern), [&](int32_t position)
+    {
+        positions.push_back(position);
+        return true;
+    });
+
+    std::sort(positions.begin(), positions.end());
+    return positions;
+}
+
+} // custom
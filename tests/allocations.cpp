@@ -0,0 +1,154 @@
+#include <iostream>
+#include <cstdlib>
+#include <new>
+#include <functional>
+#include "SuffixTree.h"
+#include "GeneralizedSuffixTree.h"
+#include "TopDocumentsIndex.h"
+#include "ApproximateMatching.h"
+#include "WildcardSearch.h"
+#include "RegexSearch.h"
+#include "SuffixArrayExport.h"
+
+
+/**
+ * @brief Checks that steady state queries with sinks don't allocate memory.
+ *
+ * Each query is run once to warm up per-thread memory, then it is repeated while global
+ * operator new counts allocations. Queries which are started from sinks of other queries
+ * must return the same results as standalone ones.
+ */
+
+static size_t allocations_count = 0;
+
+void* operator new(size_t size)
+{
+    ++allocations_count;
+    if(void* pointer = std::malloc(size == 0 ? 1 : size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+
+
+static int failures = 0;
+
+// runs query twice and checks that the second run doesn't allocate
+template <typename Query>
+void check_no_allocations(const char* name, Query&& query)
+{
+    query();
+
+    size_t before = allocations_count;
+    query();
+
+    if(allocations_count != before)
+    {
+        std::cout << name << ": " << allocations_count - before << " allocations" << std::endl;
+        ++failures;
+    }
+}
+
+// checks that results of query started from sink match results of standalone query, sinks have
+// the same type, so both queries are the same instantiation
+template <typename Query>
+void check_nested(const char* name, Query&& query)
+{
+    using Sink = std::function<bool(int32_t)>;
+
+    std::vector<int32_t> expected;
+    query(Sink([&](int32_t value)
+    {
+        expected.push_back(value);
+        return true;
+    }));
+
+    std::vector<int32_t> outer;
+    query(Sink([&](int32_t value)
+    {
+        outer.push_back(value);
+
+        std::vector<int32_t> inner;
+        query(Sink([&](int32_t value)
+        {
+            inner.push_back(value);
+            return true;
+        }));
+
+        if(inner != expected)
+        {
+            std::cout << name << ": nested query returned different results" << std::endl;
+            ++failures;
+        }
+
+        return true;
+    }));
+
+    if(outer != expected)
+    {
+        std::cout << name << ": outer query was corrupted by nested one" << std::endl;
+        ++failures;
+    }
+}
+
+
+int main()
+{
+    using Tree = custom::SuffixTree<>;
+
+    std::string source;
+    for(int idx = 0; idx < 2000; ++idx)
+        source += "abracadabra"[(idx * 7 + idx / 13) % 11];
+
+    Tree tree(source);
+    custom::GeneralizedSuffixTree<> documents({"abracadabra", "cadabra", "abba", "barbara"});
+    custom::TopDocumentsIndex<> top_index(documents, 2, 4);
+    custom::WildcardPattern<> wildcard("a?a[bc]");
+    custom::Regex<> regex("ab(ra|c)*d");
+    custom::Regex<>::Automaton automaton(regex);
+
+    auto skip = [](auto&&...) { return true; };
+
+    check_no_allocations("find_all", [&] { tree.find_all("abra", skip); });
+    check_no_allocations("top_completions", [&] { tree.top_completions("a", 5, 1, 8, skip); });
+    check_no_allocations("sample_occurrences", [&] { tree.sample_occurrences("a", 10, Tree::SampleMode::random, 1, skip); });
+    check_no_allocations("matching_statistics", [&] { tree.matching_statistics("abracadabrazzz", skip); });
+    check_no_allocations("children", [&] { Tree::Cursor cursor(tree); cursor.extend('a'); cursor.children(skip); });
+    check_no_allocations("find_documents", [&] { documents.find_documents("ab", skip); });
+    check_no_allocations("top_documents", [&] { top_index.top_documents("a", 3, skip); });
+    check_no_allocations("find_approx_hamming", [&] { custom::find_approx_hamming(tree, "abrc", 1, skip); });
+    check_no_allocations("find_approx_edit", [&] { custom::find_approx_edit(tree, "abrc", 1, custom::ApproximateMode::all, skip); });
+    check_no_allocations("find_wildcard", [&] { custom::find_wildcard(tree, wildcard, skip); });
+    check_no_allocations("find_regex", [&] { custom::find_regex(tree, automaton, skip); });
+    check_no_allocations("export_suffix_array", [&] { custom::export_suffix_array(tree, skip); });
+    check_no_allocations("export_bwt", [&] { custom::export_bwt(tree, skip); });
+
+    check_nested("find_all", [&](auto&& sink) { tree.find_all("abra", sink); });
+    check_nested("sample_occurrences", [&](auto&& sink) { tree.sample_occurrences("ab", 50, Tree::SampleMode::random, 3, sink); });
+    check_nested("find_documents", [&](auto&& sink) { documents.find_documents("a", sink); });
+    check_nested("find_approx_hamming", [&](auto&& sink)
+    {
+        custom::find_approx_hamming(tree, "abrc", 1, std::function<bool(const custom::ApproximateMatch&)>([&](const custom::ApproximateMatch& match)
+        {
+            return sink(match.position);
+        }));
+    });
+    check_nested("find_approx_edit", [&](auto&& sink)
+    {
+        custom::find_approx_edit(tree, "abrc", 1, custom::ApproximateMode::all, std::function<bool(const custom::ApproximateMatch&)>(
+            [&](const custom::ApproximateMatch& match)
+        {
+            return sink(match.position);
+        }));
+    });
+    check_nested("find_wildcard", [&](auto&& sink) { custom::find_wildcard(tree, wildcard, sink); });
+    check_nested("find_regex", [&](auto&& sink) { custom::find_regex(tree, automaton, sink); });
+
+    if(failures == 0)
+        std::cout << "all checks passed" << std::endl;
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}